@@ -4,11 +4,87 @@
 * 	Prompts for login info and allows user to access spellbook info file upon 
 * 	successful login. Spellbook info file is then able to be displayed in 3 
 * 	different ways; display all, search book by name, and search spell by effect.
+* 	Input files may be gzip (.gz) or zstd (.zst) compressed.
+* Build: g++ -std=c++17 -pthread "WI25_CS162_Project 2.cpp"
+* 	Add -DWITH_ZLIB -lz to read .gz files and -DWITH_ZSTD -lzstd to read .zst files.
+* 	Wildcards in spellbook file names are expanded only where <glob.h> exists (POSIX).
 */
 
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <algorithm>
+#include <iterator>
+#include <cctype>
+#include <cstdlib>
+#include <charconv>
+#include <new>
+#if __has_include(<glob.h>)
+#include <glob.h>
+#define HAVE_GLOB
+#endif
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef COUNT_ALLOCATIONS
+// Build with -DCOUNT_ALLOCATIONS to report how many heap allocations loading
+// the spellbook file takes. GCC warns that free is called on memory from
+// operator new once these are inlined into a caller, though both sides below
+// use malloc and free.
+thread_local long thread_allocations = 0;
+
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(std::size_t size) {
+	thread_allocations++;
+	void* p = std::malloc(size ? size : 1);
+	if (p == nullptr) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+	std::free(p);
+}
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+#endif
 
 struct spell {
 	std::string name;
@@ -16,6 +92,8 @@ struct spell {
 	std::string effect;
 };
 
+// Catalog types own their memory and are move-only, so spellbooks are never
+// copied while loading or indexing.
 struct spellbook {
 	std::string title;
 	std::string author;
@@ -23,7 +101,162 @@ struct spellbook {
 	int edition;
 	int num_spells;
 	float avg_success_rate;
-	spell *spells;
+	std::vector<spell> spells;
+
+	spellbook() = default;
+	spellbook(const spellbook&) = delete;
+	spellbook& operator=(const spellbook&) = delete;
+	spellbook(spellbook&&) = default;
+	spellbook& operator=(spellbook&&) = default;
+};
+
+// Title index laid out in flat arrays. Titles are not copied: a title id
+// stands for the title of the first spellbook that has it.
+struct title_index {
+	std::vector<int> book_offsets; // Title id -> start of its spellbooks in books
+	std::vector<int> books; // Spellbook indices, grouped by title id
+	std::vector<int> part_offsets; // Start of each part of slots
+	std::vector<int> slots; // Hash table of title ids, split into parts by title hash
+	std::vector<unsigned int> grams; // Distinct trigrams, sorted
+	std::vector<int> gram_offsets; // Trigram position -> start of its titles in gram_titles
+	std::vector<int> gram_titles; // Title ids, grouped by trigram
+
+	title_index() = default;
+	title_index(const title_index&) = delete;
+	title_index& operator=(const title_index&) = delete;
+	title_index(title_index&&) = default;
+	title_index& operator=(title_index&&) = default;
+};
+
+struct spell_ref {
+	int book; // Index of the spellbook
+	int spell; // Index of the spell in the spellbook
+};
+
+struct effect_index {
+	std::unordered_map<std::string, std::vector<spell_ref>> spells; // Effect -> spells, in catalog order
+
+	effect_index() = default;
+	effect_index(const effect_index&) = delete;
+	effect_index& operator=(const effect_index&) = delete;
+	effect_index(effect_index&&) = default;
+	effect_index& operator=(effect_index&&) = default;
+};
+
+struct result_cursor {
+	char kind; // 'd' for display all, 't' for title search, 'e' for effect search
+	std::string key; // Title or effect searched for
+	long position; // Index of the next result
+	long page_size; // Results per page, or 0 for all results at once
+};
+
+struct value_stats {
+	long count = 0;
+	float min = 0;
+	float mean = 0;
+	float max = 0;
+	float median = 0;
+	float p90 = 0; // 90th percentile
+};
+
+struct catalog_stats {
+	std::map<std::string, value_stats> effects; // Success rates by spell effect
+	std::map<std::string, value_stats> authors; // Success rates by spellbook author
+	std::map<int, value_stats> editions; // Page counts by spellbook edition
+};
+
+struct spellbook_load {
+	std::thread worker; // Background thread reading the spellbook files
+	std::atomic<bool> cancelled{false}; // Set to stop the load early
+	std::vector<spellbook> spellbooks; // All shards, in file order
+	std::vector<std::string> shard_errors; // Why each file failed to load, or empty
+	title_index titles;
+	effect_index effects;
+	std::atomic<long> shard_allocations{0}; // Heap allocations made by shard workers
+	long num_allocations = -1; // Heap allocations made by the load, if counted
+};
+
+// Chunk buffers shared by display_range and its workers. Chunk k is formatted
+// into buffers[k % buffers.size()] and printed once ready, in chunk order.
+struct render_queue {
+	bool status;
+	spellbook* spellbooks;
+	int first;
+	int last;
+	int chunk_size;
+	int num_chunks;
+	int next_chunk = 0; // Next chunk a worker will claim
+	int num_written = 0; // Chunks already printed
+	std::vector<std::ostringstream> buffers;
+	std::vector<char> ready; // Set when a buffer holds its chunk
+	std::mutex lock;
+	std::condition_variable changed;
+};
+
+// Stream buffer that reads a gzip or zstd file. A decompressor thread fills a
+// small queue of chunks ahead of the parser reading from the buffer. A file
+// that fails to decompress throws from underflow, which sets the badbit of
+// the stream reading it.
+class decompress_buf : public std::streambuf {
+public:
+	decompress_buf() = default;
+	decompress_buf(const decompress_buf&) = delete;
+	decompress_buf& operator=(const decompress_buf&) = delete;
+	~decompress_buf();
+
+	bool open(const std::string& file_name, char format);
+	void close();
+	const std::string& error() const;
+
+protected:
+	int_type underflow() override;
+
+private:
+	void decompress();
+#ifdef WITH_ZLIB
+	void decompress_gzip();
+#endif
+#ifdef WITH_ZSTD
+	void decompress_zstd();
+#endif
+	bool push_chunk(std::vector<char>&& chunk);
+
+	static const size_t chunk_size = 1 << 20;
+	static const size_t max_chunks = 4; // How far ahead of the parser to work
+
+	char format = 0; // 'g' for gzip, 'z' for zstd, 0 if no file is open
+#ifdef WITH_ZLIB
+	gzFile gzip_file = nullptr;
+#endif
+#ifdef WITH_ZSTD
+	std::FILE* zstd_file = nullptr;
+#endif
+	std::string error_message; // Why the file could not be opened or decompressed
+	std::thread worker;
+	std::mutex lock;
+	std::condition_variable changed;
+	std::deque<std::vector<char>> chunks; // Decompressed, not yet read
+	std::vector<char> current; // Chunk being read
+	bool finished = false; // Decompressor has queued its last chunk
+	bool stopping = false; // Reader is closing the buffer
+};
+
+// Input stream over a plain, gzip (.gz) or zstd (.zst) file, picked by the
+// file name's extension.
+class input_file : public std::istream {
+public:
+	input_file() : std::istream(nullptr) {}
+	explicit input_file(const std::string& file_name) : std::istream(nullptr) {
+		open(file_name);
+	}
+
+	bool open(const std::string& file_name);
+	const std::string& error() const;
+
+private:
+	std::filebuf plain;
+	decompress_buf compressed;
+	std::string plain_error; // Why the plain file could not be opened
 };
 
 struct wizard {
@@ -35,190 +268,1266 @@ struct wizard {
 };
 
 /*
- * Function: create_spells
- * Description: Allocates a dynamic array of spells of the requested size and
- * 		returns a pointer that points to it
+ * Function: worker_count
+ * Description: Picks how many worker threads to use for a parallel task.
+ * Parameters:
+ * 		num_jobs (int): Number of independent pieces of work available.
+ * Returns: The number of hardware threads, but no more than num_jobs and no
+ * 		less than 1.
+ */
+int worker_count(int num_jobs) {
+	int num_workers = std::thread::hardware_concurrency();
+
+	if (num_workers > num_jobs) {
+		num_workers = num_jobs;
+	}
+	if (num_workers < 1) {
+		num_workers = 1;
+	}
+
+	return num_workers;
+}
+
+/*
+ * Function: run_in_chunks
+ * Description: Splits a range of items into one contiguous chunk per worker and
+ * 		runs a task on every chunk at once, the calling thread taking the
+ * 		first chunk. Returns once every chunk is done.
+ * Parameters:
+ * 		num_items (int): Number of items to split.
+ * 		num_workers (int): Number of chunks, and of threads to run them on.
+ * 		task (Task): Called as task(chunk, first, last) for each chunk of
+ * 		items [first, last).
+ */
+template <typename Task>
+void run_in_chunks(int num_items, int num_workers, Task task) {
+	int chunk_size = (num_items + num_workers - 1) / num_workers;
+
+	std::vector<std::thread> workers;
+	for (int t = 1; t < num_workers; t++) {
+		int first = std::min(t * chunk_size, num_items);
+		int last = std::min(first + chunk_size, num_items);
+		workers.emplace_back(task, t, first, last);
+	}
+	task(0, 0, std::min(chunk_size, num_items));
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+/*
+ * Function: decompress_buf::open
+ * Description: Opens a compressed file. Decompression starts on a worker
+ * 		thread once the file is first read, so files opened ahead of time do
+ * 		not each hold a thread and a queue of chunks.
+ * Parameters:
+ * 		file_name (const std::string&): Name of the compressed file.
+ * 		format (char): 'g' for a gzip file, 'z' for a zstd file.
+ * Returns: Boolean value 0, or 1 if the file opened successfully. Fails if
+ * 		support for the format was not built in.
+ */
+bool decompress_buf::open(const std::string& file_name, char format) {
+	close();
+#if not defined(WITH_ZLIB) and not defined(WITH_ZSTD)
+	(void) file_name;
+#endif
+
+	if (format == 'g') {
+#ifdef WITH_ZLIB
+		gzip_file = gzopen(file_name.c_str(), "rb");
+		if (gzip_file == nullptr) {
+			error_message = std::strerror(errno);
+			return 0;
+		}
+		gzbuffer(gzip_file, 1 << 17);
+#else
+		error_message = "gzip support not built in (build with -DWITH_ZLIB -lz)";
+		return 0;
+#endif
+	} else {
+#ifdef WITH_ZSTD
+		zstd_file = std::fopen(file_name.c_str(), "rb");
+		if (zstd_file == nullptr) {
+			error_message = std::strerror(errno);
+			return 0;
+		}
+#else
+		error_message = "zstd support not built in (build with -DWITH_ZSTD -lzstd)";
+		return 0;
+#endif
+	}
+
+	this->format = format;
+	return 1;
+}
+
+/*
+ * Function: decompress_buf::close
+ * Description: Stops the decompressor thread, if running, and closes the file.
+ */
+void decompress_buf::close() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	changed.notify_all();
+	if (worker.joinable()) {
+		worker.join();
+	}
+
+#ifdef WITH_ZLIB
+	if (gzip_file != nullptr) {
+		gzclose(gzip_file);
+		gzip_file = nullptr;
+	}
+#endif
+#ifdef WITH_ZSTD
+	if (zstd_file != nullptr) {
+		std::fclose(zstd_file);
+		zstd_file = nullptr;
+	}
+#endif
+
+	format = 0;
+	error_message.clear();
+	chunks.clear();
+	current.clear();
+	setg(nullptr, nullptr, nullptr);
+	finished = false;
+	stopping = false;
+}
+
+decompress_buf::~decompress_buf() {
+	close();
+}
+
+/*
+ * Function: decompress_buf::error
+ * Description: Explains why the last file could not be opened or decompressed.
+ * 		Only read by the reader once open or underflow has failed.
+ * Returns: The reason, or an empty string if nothing failed.
+ */
+const std::string& decompress_buf::error() const {
+	return error_message;
+}
+
+/*
+ * Function: decompress_buf::underflow
+ * Description: Moves on to the next decompressed chunk once the current one
+ * 		has been read, waiting for the decompressor if it is behind. Starts
+ * 		the decompressor on the first read.
+ * Returns: The next character, or end of file once every chunk has been read.
+ * Side effects: Throws std::ios_base::failure once every chunk has been read
+ * 		if the decompressor failed, so the reading stream sets its badbit.
+ */
+decompress_buf::int_type decompress_buf::underflow() {
+	if (gptr() < egptr()) {
+		return traits_type::to_int_type(*gptr());
+	}
+
+	if (not worker.joinable()) {
+		if (format == 0) {
+			return traits_type::eof();
+		}
+		worker = std::thread(&decompress_buf::decompress, this);
+	}
+
+	std::unique_lock<std::mutex> guard(lock);
+	changed.wait(guard, [this] { return not chunks.empty() or finished; });
+	if (chunks.empty() and not error_message.empty()) {
+		throw std::ios_base::failure(error_message);
+	}
+	if (chunks.empty()) {
+		return traits_type::eof();
+	}
+	current = std::move(chunks.front());
+	chunks.pop_front();
+	guard.unlock();
+	changed.notify_all();
+
+	setg(current.data(), current.data(), current.data() + current.size());
+	return traits_type::to_int_type(*gptr());
+}
+
+/*
+ * Function: decompress_buf::push_chunk
+ * Description: Queues a decompressed chunk for the reader, waiting while the
+ * 		queue is full.
+ * Parameters:
+ * 		chunk (std::vector<char>&&): Decompressed data to queue.
+ * Returns: Boolean value 0 if the reader is closing the buffer, otherwise 1.
+ */
+bool decompress_buf::push_chunk(std::vector<char>&& chunk) {
+	std::unique_lock<std::mutex> guard(lock);
+	changed.wait(guard, [this] { return chunks.size() < max_chunks or stopping; });
+	if (stopping) {
+		return 0;
+	}
+	if (not chunk.empty()) {
+		chunks.push_back(std::move(chunk));
+	}
+	guard.unlock();
+	changed.notify_all();
+
+	return 1;
+}
+
+/*
+ * Function: decompress_buf::decompress
+ * Description: Decompresses the whole file into queued chunks, then marks the
+ * 		buffer finished. Runs on the worker thread. A corrupt or truncated
+ * 		file ends at the last chunk that decompressed, with error_message
+ * 		saying what went wrong.
+ */
+void decompress_buf::decompress() {
+#ifdef WITH_ZLIB
+	if (format == 'g') {
+		decompress_gzip();
+	}
+#endif
+#ifdef WITH_ZSTD
+	if (format == 'z') {
+		decompress_zstd();
+	}
+#endif
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		finished = true;
+	}
+	changed.notify_all();
+}
+
+#ifdef WITH_ZLIB
+/*
+ * Function: decompress_buf::decompress_gzip
+ * Description: Decompresses a gzip file into queued chunks. zlib passes data
+ * 		that is not gzip through unchanged, so that is reported as an error.
+ */
+void decompress_buf::decompress_gzip() {
+	while (true) {
+		std::vector<char> chunk(chunk_size);
+		int num_read = gzread(gzip_file, chunk.data(), chunk.size());
+		int code = Z_OK;
+		const char* message = gzerror(gzip_file, &code);
+		if (code != Z_OK or gzdirect(gzip_file)) {
+			// gzerror puts the file name in front of the message
+			std::string reason = code != Z_OK ? message : "not in gzip format";
+			size_t colon = reason.rfind(": ");
+			std::lock_guard<std::mutex> guard(lock);
+			error_message = colon == std::string::npos ? reason : reason.substr(colon + 2);
+			return;
+		}
+		if (num_read <= 0) {
+			return;
+		}
+		chunk.resize(num_read);
+		if (push_chunk(std::move(chunk)) == 0) {
+			return;
+		}
+	}
+}
+#endif
+
+#ifdef WITH_ZSTD
+/*
+ * Function: decompress_buf::decompress_zstd
+ * Description: Decompresses a zstd file into queued chunks.
+ */
+void decompress_buf::decompress_zstd() {
+	ZSTD_DStream* stream = ZSTD_createDStream();
+	std::vector<char> input(ZSTD_DStreamInSize());
+	std::vector<char> chunk(chunk_size);
+	size_t used = 0;
+	size_t result = 0; // Nonzero while a frame is not yet complete
+	bool done = 0;
+
+	while (done == 0) {
+		size_t num_read = std::fread(input.data(), 1, input.size(), zstd_file);
+		ZSTD_inBuffer in = {input.data(), num_read, 0};
+		bool output_full;
+
+		// keep going while input is left or the decompressor may still hold output
+		do {
+			ZSTD_outBuffer out = {chunk.data(), chunk.size(), used};
+			result = ZSTD_decompressStream(stream, &out, &in);
+			if (ZSTD_isError(result)) {
+				std::lock_guard<std::mutex> guard(lock);
+				error_message = ZSTD_getErrorName(result);
+				done = 1;
+				break;
+			}
+			used = out.pos;
+			output_full = used == chunk.size();
+
+			if (output_full) {
+				if (push_chunk(std::move(chunk)) == 0) {
+					ZSTD_freeDStream(stream);
+					return;
+				}
+				chunk = std::vector<char>(chunk_size);
+				used = 0;
+			}
+		} while (in.pos < in.size or output_full);
+
+		if (num_read == 0) {
+			std::lock_guard<std::mutex> guard(lock);
+			if (std::ferror(zstd_file)) {
+				error_message = std::strerror(errno);
+			} else if (result != 0 and error_message.empty()) {
+				error_message = "unexpected end of file";
+			}
+			done = 1;
+		}
+	}
+
+	chunk.resize(used);
+	push_chunk(std::move(chunk));
+	ZSTD_freeDStream(stream);
+}
+#endif
+
+/*
+ * Function: ends_with
+ * Description: Checks whether a file name ends with an extension.
+ * Parameters:
+ * 		file_name (const std::string&): File name to check.
+ * 		extension (const std::string&): Extension, such as ".gz".
+ * Returns: Boolean value 0, or 1 if file_name ends with extension.
+ */
+bool ends_with(const std::string& file_name, const std::string& extension) {
+	return file_name.size() >= extension.size() and
+	file_name.compare(file_name.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+/*
+ * Function: input_file::open
+ * Description: Opens a file for reading. Files ending in .gz or .zst are
+ * 		decompressed while they are read.
+ * Parameters:
+ * 		file_name (const std::string&): Name of the file to open.
+ * Returns: Boolean value 0, or 1 if the file opened successfully.
+ * Side effects: Sets the failbit of the stream if the file does not open.
+ */
+bool input_file::open(const std::string& file_name) {
+	bool opened = 0;
+
+	if (ends_with(file_name, ".gz")) {
+		opened = compressed.open(file_name, 'g');
+		rdbuf(&compressed);
+	} else if (ends_with(file_name, ".zst")) {
+		opened = compressed.open(file_name, 'z');
+		rdbuf(&compressed);
+	} else {
+		opened = plain.open(file_name, std::ios::in) != nullptr;
+		plain_error = opened ? "" : std::strerror(errno);
+		rdbuf(&plain);
+	}
+
+	if (opened == 0) {
+		setstate(std::ios::failbit);
+	}
+	return opened;
+}
+
+/*
+ * Function: input_file::error
+ * Description: Explains why the file could not be opened, or why reading it
+ * 		failed if the stream has its badbit set.
+ * Returns: The reason, or an empty string if nothing failed.
+ */
+const std::string& input_file::error() const {
+	if (rdbuf() == &compressed) {
+		return compressed.error();
+	}
+
+	return plain_error;
+}
+
+/*
+ * Function: read_float
+ * Description: Reads the next word of a file as a float. Unlike file >> value,
+ * 		this does not allocate for every number read, since the word is read
+ * 		into a buffer that each thread reuses.
  * Parameters:
- * 		size (int): Size of dynamic array of spells to create
- * Returns: Pointer that points to dynamically allocated array of spells
+ * 		file (std::istream&): A reference to an std::istream that is open on
+ * 		an input text file.
+ * 		value (float&): A reference to the float to read into.
+ * Side effects: Sets the failbit of file if the word is not a float, including
+ * 		when only its start is one.
  */
-spell* create_spells(int size) {
-	spell* p_spells = new spell[size];
+void read_float(std::istream& file, float& value) {
+	thread_local std::string word;
+
+	if (file >> word) {
+		const char* first = word.data();
+		const char* last = first + word.size();
 
-	return p_spells;	
+		// from_chars does not accept the leading '+' that file >> value does
+		if (first != last and *first == '+' and (last - first == 1 or first[1] != '-')) {
+			first++;
+		}
+		std::from_chars_result result = std::from_chars(first, last, value);
+		if (result.ec != std::errc() or result.ptr != last) {
+			value = 0;
+			file.setstate(std::ios::failbit);
+		}
+	}
 }
 
 /*
  * Function: read_spell_data
  * Description: Reads all of the information associated with a single spell
- * 		structure from the given spellbooks text file and returns a created
- * 		spell structure containing that information.
+ * 		structure from the given spellbooks text file straight into a new spell
+ * 		at the end of the given spells, without building a temporary spell.
  * Parameters:
- * 		file (std::ifstream&): A reference to an std::ifstream that is open on
+ * 		file (std::istream&): A reference to an std::istream that is open on
  * 		the input spellbooks text file and prepared to read information about
  * 		the next spell in a spellbook.
- * Returns: The created spell structure containing the information of the
- * 		next spell in the input file
+ * 		spells (std::vector<spell>&): A reference to the spells of the spellbook
+ * 		being read.
+ * Post-conditions: spells holds one more spell, containing the information of
+ * 		the next spell in the input file.
  */
-spell read_spell_data(std::ifstream& file) {
-	spell s;
+void read_spell_data(std::istream& file, std::vector<spell>& spells) {
+	spells.emplace_back();
+	spell& s = spells.back();
 
 	file >> s.name;
-	file >> s.success_rate;
+	read_float(file, s.success_rate);
 	file >> s.effect;
-
-	return s;
 }
 
 /*
  * Function: size_spellbooks
  * Description: Reads the number of spellbooks in a spellbook info text file.
  * Parameters:
- * 		file (std::ifstream&): Reference to std::ifstream that is open on the
+ * 		file (std::istream&): Reference to std::istream that is open on the
  * 		input spellbooks text file.
  * Returns: The number of spellbooks in a spellbook file.
  */
-int size_spellbooks(std::ifstream& file) {
-	int num_spellbooks;
-	file >> num_spellbooks;
-	
-	return num_spellbooks;
+int size_spellbooks(std::istream& file) {
+	int num_spellbooks = 0;
+	file >> num_spellbooks;
+	
+	return num_spellbooks;
+}
+
+/*
+ * Function: read_spellbook_data
+ * Description: Reads all of the information associated with a single spellbook
+ * 		structure from the given spellbooks text file straight into a new
+ * 		spellbook at the end of the given spellbooks. Note that the
+ * 		avg_success_rate member variable of the spellbook structure is
+ * 		not contained in the text file, but rather will need to be computed as
+ * 		the average (mean) success rate of all spells in the spellbook (i.e.,
+ * 		add up the success rates of all spells in the spellbook, then divide by
+ * 		the number of spells in the spellbook).
+ * Parameters:
+ * 		file (std::istream&): A reference to an std::istream that is open on
+ * 		the input spellbooks text file and prepared to read information about
+ * 		the next spellbook.
+ * 		spellbooks (std::vector<spellbook>&): A reference to the spellbooks
+ * 		read so far.
+ * Post-conditions: spellbooks holds one more spellbook, containing the
+ * 		information of the next spellbook in the file.
+ */
+void read_spellbook_data(std::istream& file, std::vector<spellbook>& spellbooks) {
+	spellbooks.emplace_back();
+	spellbook& sb = spellbooks.back();
+
+	file >> sb.title;
+	file >> sb.author;
+	file >> sb.num_pages;
+	file >> sb.edition;
+	file >> sb.num_spells;
+
+	// allocate all of the spellbook's spells at once
+	if (sb.num_spells > 0) {
+		sb.spells.reserve(sb.num_spells);
+	}
+
+	// read spells in place
+	for (int i = 0; i < sb.num_spells; i++) {
+		read_spell_data(file, sb.spells);
+	}
+
+	// calculate average success rate of spellbook's spells
+	sb.avg_success_rate = 0;
+	for (int i = 0; i < sb.num_spells; i++) {
+		sb.avg_success_rate += sb.spells[i].success_rate;
+	}
+	sb.avg_success_rate = sb.avg_success_rate / sb.num_spells;
+}
+
+/*
+ * Function: populate_spellbooks
+ * Description: Populates an array of spellbook structures using spellbook info file.
+ * 		Stops early if the load is cancelled, freeing the spellbooks read so far.
+ * Parameters:
+ * 		spellbook_info (std::istream&): A reference to std::istream that is open
+ * 		on a spellbook info file.
+ * 		num_spellbooks (int): Number of spellbooks in the file.
+ * 		cancelled (const std::atomic<bool>&): Set by another thread to stop reading.
+ * Returns: An array populated with spellbook structures using info from the
+ * 		spellbook info file, or an empty array if cancelled.
+ */
+std::vector<spellbook> populate_spellbooks(std::istream& spellbook_info, int num_spellbooks,
+const std::atomic<bool>& cancelled) {
+	std::vector<spellbook> spellbooks;
+	if (num_spellbooks > 0) {
+		spellbooks.reserve(num_spellbooks);
+	}
+
+	// populate spellbooks array with spellbook structures, stopping if the file cannot be read
+	for (int i = 0; i < num_spellbooks and not spellbook_info.bad(); i++) {
+		if (cancelled) {
+			return std::vector<spellbook>();
+		}
+		read_spellbook_data(spellbook_info, spellbooks);
+	}
+
+	return spellbooks;
+}
+
+/*
+ * Function: title_trigrams
+ * Description: Collects the distinct trigrams of a title, each packed into an
+ * 		unsigned int, in sorted order. The title is lowercased and padded so
+ * 		that its first and last characters each start a trigram of their own.
+ * Parameters:
+ * 		title (const std::string&): Title to split into trigrams.
+ * 		grams (std::vector<unsigned int>&): Filled with the trigrams. Passing
+ * 		the same vector for every title saves allocating one per title.
+ */
+void title_trigrams(const std::string& title, std::vector<unsigned int>& grams) {
+	unsigned int gram = ' ' << 8 | ' ';
+
+	grams.clear();
+	for (char c : title) {
+		gram = (gram << 8 | std::tolower(static_cast<unsigned char>(c))) & 0xffffff;
+		grams.push_back(gram);
+	}
+	grams.push_back((gram << 8 | ' ') & 0xffffff);
+
+	std::sort(grams.begin(), grams.end());
+	grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+}
+
+/*
+ * Function: num_titles
+ * Description: Counts the distinct titles in a title index.
+ * Parameters:
+ * 		index (const title_index&): Title index of the spellbooks.
+ * Returns: Number of distinct titles.
+ */
+int num_titles(const title_index& index) {
+	return index.book_offsets.empty() ? 0 : index.book_offsets.size() - 1;
+}
+
+/*
+ * Function: title_text
+ * Description: Looks up the title a title id stands for.
+ * Parameters:
+ * 		index (const title_index&): Title index of the spellbooks.
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
+ * 		id (int): Title id.
+ * Returns: The title, as stored in the first spellbook that has it.
+ */
+const std::string& title_text(const title_index& index, spellbook* spellbooks, int id) {
+	return spellbooks[index.books[index.book_offsets[id]]].title;
+}
+
+/*
+ * Function: find_title
+ * Description: Looks up the title id of an exact title.
+ * Parameters:
+ * 		index (const title_index&): Title index of the spellbooks.
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
+ * 		title (const std::string&): Title to look up.
+ * Returns: The title id, or -1 if no spellbook has the title.
+ */
+int find_title(const title_index& index, spellbook* spellbooks, const std::string& title) {
+	size_t hash = std::hash<std::string>()(title);
+	size_t num_parts = index.part_offsets.size() - 1;
+	size_t part = hash % num_parts;
+	size_t first = index.part_offsets[part];
+	size_t mask = index.part_offsets[part + 1] - first - 1;
+
+	for (size_t k = hash / num_parts & mask; index.slots[first + k] != -1; k = (k + 1) & mask) {
+		int id = index.slots[first + k];
+		if (title_text(index, spellbooks, id) == title) {
+			return id;
+		}
+	}
+
+	return -1;
+}
+
+/*
+ * Function: fill_title_part
+ * Description: Inserts the titles that hash to one part of the title table,
+ * 		recording for each of those spellbooks the first spellbook sharing its
+ * 		title. While building, slots hold spellbook indices, not title ids.
+ * Parameters:
+ * 		index (title_index*): A pointer to the index being built.
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
+ * 		hashes (const std::vector<size_t>*): A pointer to the hash of each title.
+ * 		part (int): Part of the table to fill.
+ * 		books (const std::vector<std::vector<int>>*): A pointer to the spellbooks
+ * 		whose titles hash to the part, in order, in one list per chunk.
+ * 		first_book (std::vector<int>*): A pointer to the first spellbook with
+ * 		the same title as each spellbook.
+ * 		cancelled (const std::atomic<bool>*): Set by another thread to stop early.
+ */
+void fill_title_part(title_index* index, spellbook* spellbooks, const std::vector<size_t>* hashes,
+int part, const std::vector<std::vector<int>>* books, std::vector<int>* first_book,
+const std::atomic<bool>* cancelled) {
+	size_t num_parts = index->part_offsets.size() - 1;
+	size_t first = index->part_offsets[part];
+	size_t mask = index->part_offsets[part + 1] - first - 1;
+
+	for (const std::vector<int>& chunk_books : *books) {
+		for (size_t b = 0; b < chunk_books.size() and not *cancelled; b++) {
+			int i = chunk_books[b];
+			size_t hash = (*hashes)[i];
+			size_t k = hash / num_parts & mask;
+			while (index->slots[first + k] != -1) {
+				int j = index->slots[first + k];
+				if ((*hashes)[j] == hash and spellbooks[j].title == spellbooks[i].title) {
+					break;
+				}
+				k = (k + 1) & mask;
+			}
+			if (index->slots[first + k] == -1) {
+				index->slots[first + k] = i;
+			}
+			(*first_book)[i] = index->slots[first + k];
+		}
+	}
+}
+
+/*
+ * Function: gram_position
+ * Description: Finds a trigram in the sorted trigrams of a title index.
+ * Parameters:
+ * 		index (const title_index&): Title index of the spellbooks.
+ * 		gram (unsigned int): Packed trigram.
+ * Returns: Position of the trigram, or -1 if no title has it.
+ */
+int gram_position(const title_index& index, unsigned int gram) {
+	auto found = std::lower_bound(index.grams.begin(), index.grams.end(), gram);
+	if (found == index.grams.end() or *found != gram) {
+		return -1;
+	}
+
+	return found - index.grams.begin();
+}
+
+/*
+ * Function: build_trigram_postings
+ * Description: Lists, for every trigram, the ids of the titles containing it,
+ * 		in one flat array. Each worker counts the trigrams of a chunk of titles,
+ * 		so every chunk knows where its titles go in each list, then the workers
+ * 		fill their parts of the array at once. The array is allocated once at
+ * 		its final size, and each list stays in title id order.
+ * Parameters:
+ * 		index (title_index&): A reference to the index being built. Its title
+ * 		ids must already be assigned.
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
+ * 		num_workers (int): Number of threads to build with.
+ * 		cancelled (const std::atomic<bool>&): Set by another thread to stop early,
+ * 		leaving the postings incomplete.
+ */
+void build_trigram_postings(title_index& index, spellbook* spellbooks, int num_workers,
+const std::atomic<bool>& cancelled) {
+	int num_ids = num_titles(index);
+
+	std::vector<std::unordered_map<unsigned int, int>> counts(num_workers);
+	run_in_chunks(num_ids, num_workers, [&](int t, int first, int last) {
+		std::vector<unsigned int> grams;
+		for (int id = first; id < last and not cancelled; id++) {
+			title_trigrams(title_text(index, spellbooks, id), grams);
+			for (unsigned int gram : grams) {
+				counts[t][gram]++;
+			}
+		}
+	});
+	if (cancelled) {
+		return;
+	}
+
+	for (const std::unordered_map<unsigned int, int>& chunk_counts : counts) {
+		for (const auto& count : chunk_counts) {
+			index.grams.push_back(count.first);
+		}
+	}
+	std::sort(index.grams.begin(), index.grams.end());
+	index.grams.erase(std::unique(index.grams.begin(), index.grams.end()), index.grams.end());
+
+	// chunk t writes its titles of trigram g from next[t][g], after earlier chunks
+	int num_grams = index.grams.size();
+	std::vector<std::vector<int>> next(num_workers, std::vector<int>(num_grams));
+	index.gram_offsets.assign(num_grams + 1, 0);
+	for (int g = 0; g < num_grams; g++) {
+		int offset = index.gram_offsets[g];
+		for (int t = 0; t < num_workers; t++) {
+			next[t][g] = offset;
+			auto found = counts[t].find(index.grams[g]);
+			if (found != counts[t].end()) {
+				offset += found->second;
+			}
+		}
+		index.gram_offsets[g + 1] = offset;
+	}
+	counts = std::vector<std::unordered_map<unsigned int, int>>();
+
+	index.gram_titles.resize(index.gram_offsets.back());
+	run_in_chunks(num_ids, num_workers, [&](int t, int first, int last) {
+		std::vector<unsigned int> grams;
+		for (int id = first; id < last and not cancelled; id++) {
+			title_trigrams(title_text(index, spellbooks, id), grams);
+			for (unsigned int gram : grams) {
+				index.gram_titles[next[t][gram_position(index, gram)]++] = id;
+			}
+		}
+	});
+}
+
+/*
+ * Function: build_title_index
+ * Description: Builds the exact and trigram title indexes for an array of
+ * 		spellbooks. Each distinct title is indexed once, so repeated titles do
+ * 		not grow the trigram posting lists. Title ids follow the order in which
+ * 		titles first appear. Large catalogs are indexed by several threads:
+ * 		the title table is split into one part per thread by title hash, and
+ * 		the other steps work on chunks of spellbooks or titles. Stops early if
+ * 		the load is cancelled.
+ * Parameters:
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
+ * 		num_books (int): Number of spellbooks in dynamic array of spellbook structures.
+ * 		cancelled (const std::atomic<bool>&): Set by another thread to stop building.
+ * Returns: The title index for the spellbooks, or an empty index if cancelled.
+ */
+title_index build_title_index(spellbook* spellbooks, int num_books, const std::atomic<bool>& cancelled) {
+	const int min_chunk_size = 4096;
+	int num_workers = worker_count((num_books + min_chunk_size - 1) / min_chunk_size);
+	int num_parts = num_workers;
+	title_index index;
+
+	// hash titles, listing the spellbooks of each part of the table by chunk
+	std::vector<size_t> hashes(num_books);
+	std::vector<std::vector<std::vector<int>>> part_books(num_parts, std::vector<std::vector<int>>(num_workers));
+	run_in_chunks(num_books, num_workers, [&](int t, int first, int last) {
+		for (int i = first; i < last; i++) {
+			hashes[i] = std::hash<std::string>()(spellbooks[i].title);
+			part_books[hashes[i] % num_parts][t].push_back(i);
+		}
+	});
+
+	// size each part of the table to stay at most half full
+	index.part_offsets.push_back(0);
+	for (int p = 0; p < num_parts; p++) {
+		int count = 0;
+		for (const std::vector<int>& chunk_books : part_books[p]) {
+			count += chunk_books.size();
+		}
+		int size = 1;
+		while (size < 2 * count) {
+			size *= 2;
+		}
+		index.part_offsets.push_back(index.part_offsets.back() + size);
+	}
+	index.slots.assign(index.part_offsets.back(), -1);
+
+	std::vector<int> first_book(num_books);
+	run_in_chunks(num_parts, num_workers, [&](int, int first, int last) {
+		for (int p = first; p < last; p++) {
+			fill_title_part(&index, spellbooks, &hashes, p, &part_books[p], &first_book, &cancelled);
+		}
+	});
+	if (cancelled) {
+		return title_index();
+	}
+	hashes = std::vector<size_t>();
+	part_books = std::vector<std::vector<std::vector<int>>>();
+
+	// number titles in order of first appearance, counting each chunk's new titles first
+	std::vector<int> title_ids(num_books);
+	std::vector<int> chunk_ids(num_workers + 1, 0);
+	run_in_chunks(num_books, num_workers, [&](int t, int first, int last) {
+		int num_new = 0;
+		for (int i = first; i < last; i++) {
+			num_new += first_book[i] == i;
+		}
+		chunk_ids[t + 1] = num_new;
+	});
+	for (int t = 0; t < num_workers; t++) {
+		chunk_ids[t + 1] += chunk_ids[t];
+	}
+	run_in_chunks(num_books, num_workers, [&](int t, int first, int last) {
+		int id = chunk_ids[t];
+		for (int i = first; i < last; i++) {
+			if (first_book[i] == i) {
+				title_ids[i] = id++;
+			}
+		}
+	});
+	run_in_chunks(num_books, num_workers, [&](int, int first, int last) {
+		for (int i = first; i < last; i++) {
+			if (first_book[i] != i) {
+				title_ids[i] = title_ids[first_book[i]];
+			}
+		}
+	});
+	int num_ids = chunk_ids[num_workers];
+	first_book = std::vector<int>();
+	run_in_chunks(index.slots.size(), num_workers, [&](int, int first, int last) {
+		for (int k = first; k < last; k++) {
+			if (index.slots[k] != -1) {
+				index.slots[k] = title_ids[index.slots[k]];
+			}
+		}
+	});
+
+	// group spellbooks by title
+	index.book_offsets.assign(num_ids + 1, 0);
+	for (int i = 0; i < num_books; i++) {
+		index.book_offsets[title_ids[i] + 1]++;
+	}
+	for (int id = 0; id < num_ids; id++) {
+		index.book_offsets[id + 1] += index.book_offsets[id];
+	}
+	std::vector<int> next(index.book_offsets.begin(), index.book_offsets.end() - 1);
+	index.books.resize(num_books);
+	for (int i = 0; i < num_books; i++) {
+		index.books[next[title_ids[i]]++] = i;
+	}
+
+	build_trigram_postings(index, spellbooks, num_workers, cancelled);
+	if (cancelled) {
+		return title_index();
+	}
+
+	return index;
+}
+
+/*
+ * Function: edit_distance
+ * Description: Computes the case-insensitive Levenshtein distance between two
+ * 		titles using two rows of the distance table.
+ * Parameters:
+ * 		a (const std::string&): First title.
+ * 		b (const std::string&): Second title.
+ * Returns: Minimum number of single character edits that turn a into b.
+ */
+int edit_distance(const std::string& a, const std::string& b) {
+	std::vector<int> prev(b.size() + 1);
+	std::vector<int> curr(b.size() + 1);
+
+	for (size_t j = 0; j <= b.size(); j++) {
+		prev[j] = j;
+	}
+
+	for (size_t i = 1; i <= a.size(); i++) {
+		curr[0] = i;
+		for (size_t j = 1; j <= b.size(); j++) {
+			int cost = std::tolower(static_cast<unsigned char>(a[i - 1])) !=
+			std::tolower(static_cast<unsigned char>(b[j - 1]));
+			curr[j] = std::min({prev[j] + 1, curr[j - 1] + 1, prev[j - 1] + cost});
+		}
+		std::swap(prev, curr);
+	}
+
+	return prev[b.size()];
+}
+
+/*
+ * Function: title_visible
+ * Description: Checks whether user may see a title. A student only sees titles
+ * 		with a spellbook holding spells other than poison and death.
+ * Parameters:
+ * 		index (const title_index&): Title index of the spellbooks.
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
+ * 		id (int): Title id.
+ * 		status (bool): A boolean value indicating whether user is a student or not.
+ * Returns: Boolean value 1 if a spellbook with the title is shown to user, otherwise 0.
+ */
+bool title_visible(const title_index& index, spellbook* spellbooks, int id, bool status) {
+	if (status == 0) {
+		return 1;
+	}
+
+	for (int k = index.book_offsets[id]; k < index.book_offsets[id + 1]; k++) {
+		spellbook& sb = spellbooks[index.books[k]];
+		for (int j = 0; j < sb.num_spells; j++) {
+			if (sb.spells[j].effect != "poison" and sb.spells[j].effect != "death") {
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Function: fuzzy_titles
+ * Description: Finds the titles closest to a query. Titles sharing a trigram
+ * 		with the query become candidates. Each edit changes at most three
+ * 		trigrams and one character of length, so the shared trigram count and
+ * 		length of a candidate bound its edit distance from below. Candidates
+ * 		are ranked in order of that bound, stopping once no remaining
+ * 		candidate can beat or tie the matches found so far. Posting lists of
+ * 		very common trigrams are skipped while rarer ones are available.
+ * Parameters:
+ * 		index (const title_index&): Title index of the loaded spellbooks.
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
+ * 		status (bool): A boolean value indicating whether user is a student or not.
+ * 		Titles user cannot see are never suggested.
+ * 		query (const std::string&): Title input by user.
+ * 		max_results (int): Largest number of titles to return.
+ * Returns: Title ids of the best matches, closest first.
+ */
+std::vector<int> fuzzy_titles(const title_index& index, spellbook* spellbooks, bool status,
+const std::string& query, int max_results) {
+	const int max_postings = 50000;
+	int skipped = 0;
+
+	// look up posting lists, rarest trigram first
+	std::vector<unsigned int> grams;
+	std::vector<int> lists;
+	title_trigrams(query, grams);
+	for (unsigned int gram : grams) {
+		int g = gram_position(index, gram);
+		if (g != -1) {
+			lists.push_back(g);
+		}
+	}
+	auto list_size = [&index](int g) { return index.gram_offsets[g + 1] - index.gram_offsets[g]; };
+	std::sort(lists.begin(), lists.end(), 
+	[&list_size](int a, int b) { return list_size(a) < list_size(b); });
+
+	// count shared trigrams per title
+	std::unordered_map<int, int> shared;
+	for (size_t i = 0; i < lists.size(); i++) {
+		if (i > 0 and list_size(lists[i]) > max_postings) {
+			skipped = lists.size() - i;
+			break;
+		}
+		for (int k = index.gram_offsets[lists[i]]; k < index.gram_offsets[lists[i] + 1]; k++) {
+			shared[index.gram_titles[k]]++;
+		}
+	}
+
+	// bound the edit distance of each candidate, counting skipped trigrams as shared
+	std::vector<std::pair<int, int>> candidates;
+	for (const std::pair<const int, int>& count : shared) {
+		if (not title_visible(index, spellbooks, count.first, status)) {
+			continue;
+		}
+		int missing = std::max<int>(grams.size() - count.second - skipped, 0);
+		int length = title_text(index, spellbooks, count.first).size();
+		int bound = std::max<int>((missing + 2) / 3, std::abs(length - (int) query.size()));
+		candidates.emplace_back(bound, count.first);
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	// rank candidates by edit distance, closest and then lowest id first
+	std::vector<std::pair<int, int>> ranked;
+	for (const std::pair<int, int>& candidate : candidates) {
+		if (ranked.size() == (size_t) max_results and candidate.first > ranked.back().first) {
+			break;
+		}
+		std::pair<int, int> match(edit_distance(query, title_text(index, spellbooks, candidate.second)),
+		candidate.second);
+		if (ranked.size() == (size_t) max_results and not (match < ranked.back())) {
+			continue;
+		}
+		ranked.insert(std::upper_bound(ranked.begin(), ranked.end(), match), match);
+		if (ranked.size() > (size_t) max_results) {
+			ranked.pop_back();
+		}
+	}
+
+	std::vector<int> results;
+	for (const std::pair<int, int>& match : ranked) {
+		results.push_back(match.second);
+	}
+
+	return results;
+}
+
+/*
+ * Function: build_effect_index
+ * Description: Indexes every spell of an array of spellbooks by its effect.
+ * 		Worker threads each index a chunk of spellbooks, and the chunks are
+ * 		then appended in order. Stops early if the load is cancelled.
+ * Parameters:
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
+ * 		num_books (int): Number of spellbooks in dynamic array of spellbook structures.
+ * 		cancelled (const std::atomic<bool>&): Set by another thread to stop building.
+ * Returns: The effect index for the spellbooks, or an empty index if
+ * 		cancelled. Spells of each effect are listed in the order they appear
+ * 		in the spellbooks.
+ */
+effect_index build_effect_index(spellbook* spellbooks, int num_books, const std::atomic<bool>& cancelled) {
+	const int min_chunk_size = 4096;
+	int num_workers = worker_count((num_books + min_chunk_size - 1) / min_chunk_size);
+
+	std::vector<effect_index> partials(num_workers);
+	run_in_chunks(num_books, num_workers, [&](int t, int first, int last) {
+		for (int i = first; i < last and not cancelled; i++) {
+			for (int j = 0; j < spellbooks[i].num_spells; j++) {
+				partials[t].spells[spellbooks[i].spells[j].effect].push_back(spell_ref{i, j});
+			}
+		}
+	});
+	if (cancelled) {
+		return effect_index();
+	}
+
+	// append chunks in order
+	effect_index& index = partials[0];
+	for (int t = 1; t < num_workers; t++) {
+		for (auto& effect : partials[t].spells) {
+			std::vector<spell_ref>& refs = index.spells[effect.first];
+			if (refs.empty()) {
+				refs = std::move(effect.second);
+			} else {
+				refs.insert(refs.end(), effect.second.begin(), effect.second.end());
+			}
+		}
+		partials[t] = effect_index();
+	}
+
+	return std::move(index);
 }
 
 /*
- * Function: create_spellbooks
- * Description: Allocates a dynamic array of spellbooks of the requested size.
+ * Function: load_shards
+ * Description: Reads spellbook info files until none are left. Each file is a
+ * 		shard opened only once a worker picks it, then read with its own
+ * 		size_spellbooks and populate_spellbooks pass. Several of these run at
+ * 		once, sharing next_shard to pick files, so no more files are open at
+ * 		a time than there are workers.
  * Parameters:
- * 		size (int): Size of dynamic array of spellbooks to create
- * Returns: Pointer that points to dynamically allocated array of spellbooks
+ * 		load (spellbook_load*): A pointer to the load the shards belong to. A
+ * 		file that fails to open or read gets a message in load->shard_errors
+ * 		and adds no spellbooks.
+ * 		file_names (const std::vector<std::string>*): A pointer to the names of
+ * 		the spellbook info files.
+ * 		shards (std::vector<std::vector<spellbook>>*): A pointer to the
+ * 		spellbooks of each file, filled in by the workers.
+ * 		next_shard (std::atomic<int>*): A pointer to the index of the next file
+ * 		to read.
  */
-spellbook* create_spellbooks(int size) {
-	spellbook* p_spellbooks = new spellbook[size];
-
-	return p_spellbooks;
+void load_shards(spellbook_load* load, const std::vector<std::string>* file_names,
+std::vector<std::vector<spellbook>>* shards, std::atomic<int>* next_shard) {
+#ifdef COUNT_ALLOCATIONS
+	long start_allocations = thread_allocations;
+#endif
+	int num_shards = file_names->size();
+
+	for (int k = (*next_shard)++; k < num_shards and not load->cancelled; k = (*next_shard)++) {
+		input_file spellbook_info((*file_names)[k]);
+		if (spellbook_info.fail()) {
+			load->shard_errors[k] = "cannot open spellbook file " + (*file_names)[k] + ": " +
+			spellbook_info.error();
+			continue;
+		}
+		int num_spellbooks = size_spellbooks(spellbook_info);
+		(*shards)[k] = populate_spellbooks(spellbook_info, num_spellbooks, load->cancelled);
+		if (spellbook_info.bad()) {
+			load->shard_errors[k] = "cannot read spellbook file " + (*file_names)[k] + ": " +
+			spellbook_info.error();
+			(*shards)[k] = std::vector<spellbook>();
+		}
+	}
+#ifdef COUNT_ALLOCATIONS
+	load->shard_allocations += thread_allocations - start_allocations;
+#endif
 }
 
 /*
- * Function: read_spellbook_data
- * Description: Reads all of the information associated with a single spellbook
- * 		structure from the given spellbooks text file and returns a created
- * 		spellbook structure containing that information. Note that the
- * 		avg_success_rate member variable of the returned spellbook structure is
- * 		not contained in the text file, but rather will need to be computed as
- * 		the average (mean) success rate of all spells in the spellbook (i.e.,
- * 		add up the success rates of all spells in the spellbook, then divide by
- * 		the number of spells in the spellbook).
+ * Function: load_spellbooks
+ * Description: Reads the spellbook info files, as many at once as there are
+ * 		cores, then merges them in file order into one catalog and builds its
+ * 		title and effect indexes. Runs on the background thread started by
+ * 		start_spellbook_load.
  * Parameters:
- * 		file (std::ifstream&): A reference to an std::ifstream that is open on
- * 		the input spellbooks text file and prepared to read information about
- * 		the next spellbook.
- * Returns: The created spellbook structure containing the information of the
- * 		next spellbook in the file
+ * 		load (spellbook_load*): A pointer to the load to fill in.
+ * 		file_names (const std::vector<std::string>*): A pointer to the names of
+ * 		the spellbook info files.
  */
-spellbook read_spellbook_data(std::ifstream& file) {
-	spellbook sb;
+void load_spellbooks(spellbook_load* load, const std::vector<std::string>* file_names) {
+	std::vector<std::vector<spellbook>> shards(file_names->size());
+	std::atomic<int> next_shard{0};
 
-	file >> sb.title;
-	file >> sb.author;
-	file >> sb.num_pages;
-	file >> sb.edition;
-	file >> sb.num_spells;
+	load->shard_errors.resize(file_names->size());
 
-	// create dynamic array of spells
-	sb.spells = create_spells(sb.num_spells);
+	// the load thread reads shards too, alongside any extra workers
+	int num_workers = worker_count(shards.size());
+	std::vector<std::thread> workers;
+	for (int t = 1; t < num_workers; t++) {
+		workers.emplace_back(load_shards, load, file_names, &shards, &next_shard);
+	}
+	load_shards(load, file_names, &shards, &next_shard);
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
 
-	// populate dynamic array of spells with spell structures
-	for (int i = 0; i < sb.num_spells; i++) {
-		sb.spells[i] = read_spell_data(file);
+	if (load->cancelled) {
+		return;
 	}
 
-	// calculate average success rate of spellbook's spells
-	sb.avg_success_rate = 0;
-	for (int i = 0; i < sb.num_spells; i++) {
-		sb.avg_success_rate += sb.spells[i].success_rate;
+	// merge shards into one catalog
+	size_t num_spellbooks = 0;
+	for (const std::vector<spellbook>& shard : shards) {
+		num_spellbooks += shard.size();
 	}
-	sb.avg_success_rate = sb.avg_success_rate / sb.num_spells;
+	load->spellbooks.reserve(num_spellbooks);
+	for (std::vector<spellbook>& shard : shards) {
+		if (load->cancelled) {
+			return;
+		}
+		std::move(shard.begin(), shard.end(), std::back_inserter(load->spellbooks));
+		shard = std::vector<spellbook>();
+	}
+#ifdef COUNT_ALLOCATIONS
+	load->num_allocations = load->shard_allocations;
+#endif
 
-	return sb;
+	load->titles = build_title_index(load->spellbooks.data(), load->spellbooks.size(), load->cancelled);
+	if (load->cancelled) {
+		return;
+	}
+	load->effects = build_effect_index(load->spellbooks.data(), load->spellbooks.size(), load->cancelled);
 }
 
 /*
- * Function: populate_spellbooks
- * Description: Populates dynamic array of spellbook structures using spellbook info file.
+ * Function: start_spellbook_load
+ * Description: Starts reading the spellbook info files on a background thread
+ * 		so it overlaps with logging in.
  * Parameters:
- * 		spellbook_info (std::ifstream&): A reference to std::ifstream that is open
- * 		on a spellbook info file.
- * 		num_spellbooks (int): Size of dynamic array of spellbook structures.
- * Returns: A pointer to a dynamic array populated with spellbook structures using
- * 		info from the spellbook info file. 
+ * 		load (spellbook_load&): A reference to the load to start.
+ * 		file_names (const std::vector<std::string>&): A reference to the names
+ * 		of the spellbook info files. Must outlive the load.
  */
-spellbook* populate_spellbooks(std::ifstream& spellbook_info, int num_spellbooks) {
-	// store spellbook file info to memory
-	// assigns pointer to a dynamic array of spellbooks
-	spellbook* spellbooks_array = create_spellbooks(num_spellbooks);
+void start_spellbook_load(spellbook_load& load, const std::vector<std::string>& file_names) {
+	load.worker = std::thread(load_spellbooks, &load, &file_names);
+}
 
-	// populate spellbooks array with spellbook structures 
-	for (int i = 0; i < num_spellbooks; i++) {
-		spellbooks_array[i] = read_spellbook_data(spellbook_info);
+/*
+ * Function: finish_spellbook_load
+ * Description: Waits for a background spellbook load to finish, if it has not
+ * 		already.
+ * Parameters:
+ * 		load (spellbook_load&): A reference to the load to wait for.
+ * Post-conditions: load.spellbooks, load.titles and load.effects hold the
+ * 		loaded spellbooks.
+ */
+void finish_spellbook_load(spellbook_load& load) {
+	if (load.worker.joinable()) {
+		load.worker.join();
 	}
+}
+
+/*
+ * Function: cancel_spellbook_load
+ * Description: Stops a background spellbook load and frees everything it read.
+ * Parameters:
+ * 		load (spellbook_load&): A reference to the load to cancel.
+ * Post-conditions: All dynamic memory of the load is freed.
+ */
+void cancel_spellbook_load(spellbook_load& load) {
+	load.cancelled = true;
+	finish_spellbook_load(load);
 
-	// returns pointer to dynamic array
-	return spellbooks_array;
+	load.spellbooks = std::vector<spellbook>();
+	load.titles = title_index();
+	load.effects = effect_index();
 }
 
 /*
- * Function: delete_spells
- * Description: Deletes a given dynamic array of spells and updates its pointer
- * 		to be nullptr.
+ * Function: print_load_errors
+ * Description: Reports the spellbook info files that failed to load. Their
+ * 		spellbooks are left out of the catalog.
  * Parameters:
- * 		spells (spell*&): A reference to the pointer that points to the dynamic
- * 			array of spells to be deleted.
- * Post-conditions: 1. Dynamic array of spells should be deleted. 2. spells
- * 		pointer parameter should be set to nullptr. Since this parameter is
- * 		passed by reference, the corresponding argument will be set to nullptr
- * 		as well.
+ * 		load (const spellbook_load&): A reference to a finished load.
+ * Side effects: Prints error messages to terminal.
  */
-void delete_spells(spell*& spells) {
-	delete[] spells;
-	spells = nullptr;
+void print_load_errors(const spellbook_load& load) {
+	for (const std::string& error : load.shard_errors) {
+		if (not error.empty()) {
+			std::cout << "Error: " << error << std::endl;
+		}
+	}
 }
 
 /*
- * Function: delete_spellbooks
- * Description: Deletes all of the dynamic memory associated with the given
- * 		array of spellbooks, including the arrays of spells inside each
- * 		spellbook. The size parameter indicates the size of the array of
- * 		spellbooks.
+ * Function: print_load_allocations
+ * Description: Reports the heap allocations made while loading spellbooks,
+ * 		when the program is built with COUNT_ALLOCATIONS, and checks them
+ * 		against the loader's limit: one allocation per spellbook for its
+ * 		spells, one per title, author, spell name or effect too long for
+ * 		std::string's inline buffer (15 characters in libstdc++), and a few per
+ * 		file for its stream and read buffers. Spells whose strings fit inline
+ * 		cost nothing, so a catalog of short strings loads with under one
+ * 		allocation per spell. Loads with file errors are not checked, since
+ * 		the spellbooks of a failed file are dropped.
  * Parameters:
- * 		spellbooks (spellbook*&): A reference to the pointer that points to the
- * 			dynamic array of spellbooks to be deleted
- * 		size (int): Number of spellbooks
- * Post-conditions: 1. Dynamic arrays of spells within each spellbook should
- * 		be deleted (see hint). 2. Dynamic array of spellbooks should be deleted.
- * 		3. spellbooks pointer parameter should be set to nullptr. Since this
- * 		parameter is passed by reference, the corresponding argument will be set
- * 		to nullptr as well.
+ * 		load (const spellbook_load&): A reference to a finished load.
+ * Returns: Boolean value 0 if the load made more allocations than the limit,
+ * 		otherwise 1.
+ * Side effects: Prints allocation counts to terminal, and an error message
+ * 		if the limit is exceeded.
  */
-void delete_spellbooks(spellbook*& spellbooks, int size) {
+bool print_load_allocations(const spellbook_load& load) {
+	const long allocations_per_file = 16;
+	if (load.num_allocations < 0) {
+		return 1;
+	}
 
-	for (int i = 0; i < size; i++) {
-		delete_spells(spellbooks[i].spells);
+	size_t inline_size = std::string().capacity();
+	long num_spells = 0;
+	long limit = load.shard_errors.size() * allocations_per_file;
+	for (const spellbook& sb : load.spellbooks) {
+		num_spells += sb.spells.size();
+		limit += not sb.spells.empty();
+		limit += (sb.title.size() > inline_size) + (sb.author.size() > inline_size);
+		for (const spell& s : sb.spells) {
+			limit += (s.name.size() > inline_size) + (s.effect.size() > inline_size);
+		}
 	}
-	
-	delete[] spellbooks;
-	spellbooks = nullptr;
+
+	std::cout << "Loaded " << load.spellbooks.size() << " spellbooks and " << num_spells
+	<< " spells with " << load.num_allocations << " heap allocations";
+	if (num_spells > 0) {
+		std::cout << " (" << (double) load.num_allocations / num_spells << " per spell)";
+	}
+	std::cout << "." << std::endl;
+
+	bool file_failed = std::any_of(load.shard_errors.begin(), load.shard_errors.end(),
+	[](const std::string& error) { return not error.empty(); });
+	if (not file_failed and load.num_allocations > limit) {
+		std::cout << "Error: loading took more than the limit of " << limit << " heap allocations."
+		<< std::endl;
+		return 0;
+	}
+
+	return 1;
 }
 
 /*
  * Function: size_wizards
  * Description: Reads the number of wizards in a wizard info text file.
  * Parameters:
- *  	file (std::ifstream&): A reference to std::ifstream that is open on the
+ *  	file (std::istream&): A reference to std::istream that is open on the
  * 		input wizard text file.
  * Returns: The number of wizards in the wizards file.
  */
-int size_wizards(std::ifstream& file) {
-	int num_wizards;
+int size_wizards(std::istream& file) {
+	int num_wizards = 0;
 	file >> num_wizards;
 
 	return num_wizards;
@@ -241,12 +1550,12 @@ wizard* create_wizards(int size) {
  * Function: read_wizard_data
  * Description: Reads the wizard data for the ID and password input by user.
  * Parameters:
- * 		file (std::ifstream&): A reference to a std::ifstream that is open on
+ * 		file (std::istream&): A reference to a std::istream that is open on
  * 		the input wizards info text file.
  * Returns: A wizard structure containing the information from the 
  * 		wizard info text file.
  */
-wizard read_wizard_data(std::ifstream& file) {
+wizard read_wizard_data(std::istream& file) {
 	wizard wiz;
 
 	file >> wiz.name;
@@ -262,12 +1571,12 @@ wizard read_wizard_data(std::ifstream& file) {
  * Function: populate_wizards 
  * Description: Populates a dynamic array of wizard structures using wizard info file.
  * Parameters:
- * 		wizard_info (std::ifstream&): A reference to std::ifstream that is open on
+ * 		wizard_info (std::istream&): A reference to std::istream that is open on
  * 		a wizard info file.
  * 		num_wizards (int): Size of dynamic array of wizard structures.
  * Returns: A pointer to a dynamic array of wizard structures.
  */
-wizard* populate_wizards(std::ifstream& wizard_info, int num_wizards) {
+wizard* populate_wizards(std::istream& wizard_info, int num_wizards) {
 	// store wizard file info to memory
 	// create dynamic array of wizards, reading first line of ifstream file for size
 	wizard* wizards_array = create_wizards(num_wizards);
@@ -311,32 +1620,81 @@ std::string wizard_file() {
 
 /*
  * Function: spellbook_file
- * Description: Prompts the user for the name of the file that holds spellbooks
- * 		and spells information.
- * Returns: The user's string input for spellbook info file name.
+ * Description: Prompts the user for the names of the files that hold spellbooks
+ * 		and spells information. Several files are separated by commas, and
+ * 		each name may be a pattern such as dept_*.txt.
+ * Returns: The user's string input for spellbook info file names.
  */
 std::string spellbook_file() {
 	std::string file_name;
 
-	std::cout << "Enter the spellbook info file name: ";
+	std::cout << "Enter the spellbook info file name(s): ";
 	std::cin >> file_name;
 
 	return file_name;
 }
 
+/*
+ * Function: expand_file_names
+ * Description: Splits a comma separated list of file names and expands any
+ * 		patterns in it. A pattern that matches nothing is kept as it is, so
+ * 		opening it reports the missing file.
+ * Parameters:
+ * 		file_names (const std::string&): Comma separated file names or patterns.
+ * Returns: The file names, in the order given and with each pattern's
+ * 		matches sorted.
+ */
+std::vector<std::string> expand_file_names(const std::string& file_names) {
+	std::vector<std::string> expanded;
+	size_t start = 0;
+
+	while (start <= file_names.size()) {
+		size_t end = file_names.find(',', start);
+		if (end == std::string::npos) {
+			end = file_names.size();
+		}
+		std::string pattern = file_names.substr(start, end - start);
+		start = end + 1;
+
+		if (pattern.empty()) {
+			continue;
+		}
+
+#ifdef HAVE_GLOB
+		glob_t matches;
+		if (glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+			for (size_t i = 0; i < matches.gl_pathc; i++) {
+				expanded.push_back(matches.gl_pathv[i]);
+			}
+		} else {
+			expanded.push_back(pattern);
+		}
+		globfree(&matches);
+#else
+		expanded.push_back(pattern);
+#endif
+	}
+
+	return expanded;
+}
+
 /*
  * Function: file_prompt
- * Description: Attempts to open wizard info and spellbook info file inputs.
- * 		If a file open fails, program prints error message and terminates.
+ * Description: Attempts to open the wizard info file and checks that every
+ * 		spellbook info file can be opened. Spellbook files are only opened
+ * 		for reading once the load gets to them, so a long list of files does
+ * 		not hold a file descriptor each. If a check fails, program prints
+ * 		error message and terminates.
  * Parameters:
- * 		wizard_file (std::ifstream&): A reference to a std::ifstream for wizard info.
- * 		spellbook_file (std::ifstream&): A reference to a std::ifstream for spellbook info.
- * Returns: Boolean value 0, or 1 if both files open successfully.
+ * 		wizard_file (input_file&): A reference to an input_file for wizard info.
+ * 		spellbook_names (std::vector<std::string>&): A reference to the names of
+ * 		the spellbook info files, filled in from the user's input.
+ * Returns: Boolean value 0, or 1 if all files open successfully.
  * Side effects:
  * 		Prints error messages to terminal if file open fails.
- * 		Modifies std::ifstreams to open wizard or spellbook file.
+ * 		Modifies wizard_info to open the wizard file.
  */
-bool file_prompt(std::ifstream& wizard_info, std::ifstream& spellbook_info) {
+bool file_prompt(input_file& wizard_info, std::vector<std::string>& spellbook_names) {
 	bool opened_files = 0;
 
 	wizard_info.open(wizard_file());
@@ -344,14 +1702,22 @@ bool file_prompt(std::ifstream& wizard_info, std::ifstream& spellbook_info) {
 		std::cout << "Error: wizard file not found." << std::endl;
 		return opened_files;
 	} 
-	spellbook_info.open(spellbook_file());
-	if (spellbook_info.fail()) {
+
+	spellbook_names = expand_file_names(spellbook_file());
+	if (spellbook_names.empty()) {
 		std::cout << "Error: spellbook file not found." << std::endl;
 		return opened_files;
-	} else {
-		opened_files = 1;
-		return opened_files;
 	}
+	for (const std::string& name : spellbook_names) {
+		input_file check(name);
+		if (check.fail()) {
+			std::cout << "Error: cannot open spellbook file " << name << ": " << check.error() << std::endl;
+			return opened_files;
+		}
+	}
+
+	opened_files = 1;
+	return opened_files;
 }
 
 /*
@@ -417,139 +1783,519 @@ bool log_in(wizard*& wiz_array, int& num_wizards) {
 			} 
 		}
 
-		if (login_success == 0) {
-		std::cout << "Invalid ID or password." << std::endl;
+		if (login_success == 0) {
+		std::cout << "Invalid ID or password." << std::endl;
+		}
+	}
+return login_success;
+}
+
+/*
+ * Function: print_wizard
+ * Description: Prints the information of the wizard that has logged in.
+ * Parameters: 
+ * 		login_wizard (wizard*): A pointer to the wizard array containing
+ *  	information	from the wizard info text file.		
+ * Side effects: Prints logged in wizard's information to terminal.
+ */
+void print_wizard(wizard* login_wizard, int which_wiz) {
+	std::cout << "Hello, " << login_wizard[which_wiz].name << "." << std::endl;
+	std::cout << "ID: " << login_wizard[which_wiz].id << std::endl;
+	std::cout << "Status: " << login_wizard[which_wiz].position_title << std::endl;
+	std::cout << "Beard Length: " << login_wizard[which_wiz].beard_length << std::endl;
+}
+
+/*
+ * Function: check_status
+ * Description: Checks whether logged in user is a student.
+ * Parameters:
+ * 		wizards (wizard*): A pointer to the wizard structures array.
+ * 		wiz_number (int): The index of the logged in wizard in the wizard array.
+ * Returns: Boolean value 0, or 1 if user is a student.
+ */
+bool check_status(wizard* wizards, int wiz_number) {
+	bool status = 0;
+
+	if (wizards[wiz_number].position_title == "Student") {
+		status = 1;
+	}
+
+	return status;
+}
+
+/*
+ * Function: print_spells_info
+ * Description: Prints information of a spell.
+ * Parameters:
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
+ * 		num_spellbook (int): Index of the spellbook to be printed.
+ * 		status (bool): A boolean value indicating whether user is a student or not.
+ * 		out (std::ostream&): Stream to write to.
+ * Side effects: Writes spell information to out.
+ */
+void print_spells_info(spellbook* spellbooks, int num_spellbook, bool status, std::ostream& out) {
+	
+	for (int i = 0; i < spellbooks[num_spellbook].num_spells; i++) {
+		if (status == 1) {
+			if (spellbooks[num_spellbook].spells[i].effect == "poison" or
+			spellbooks[num_spellbook].spells[i].effect == "death") {
+				// do nothing
+			} else {
+			out << spellbooks[num_spellbook].spells[i].name << " " <<
+			spellbooks[num_spellbook].spells[i].success_rate << " " <<
+			spellbooks[num_spellbook].spells[i].effect << std::endl;
+			}
+		} else {
+			out << spellbooks[num_spellbook].spells[i].name << " " <<
+			spellbooks[num_spellbook].spells[i].success_rate << " " <<
+			spellbooks[num_spellbook].spells[i].effect << std::endl;
+		}
+	}
+}
+
+/*
+ * Function: print_spellbook_info
+ * Description: Prints information of a spellbook, including its spells' info.
+ * Parameters:
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
+ * 		num_spellbook (int): Index of the spellbook to be printed.
+ * 		status (bool): A boolean value indicating whether user is a student or not.
+ * 		total_spells (int): Number of spells available for user to see.
+ * 		out (std::ostream&): Stream to write to.
+ * Side effects: Writes spellbook information to out.
+ */
+void print_spellbook_info(spellbook* spellbooks, int num_spellbook, bool status, int total_spells,
+std::ostream& out) {
+		out << "Title: " << spellbooks[num_spellbook].title << " | Author: " 
+		<< spellbooks[num_spellbook].author << std::endl;
+		out << "# of pages: " << spellbooks[num_spellbook].num_pages << 
+		" | Edition: " << spellbooks[num_spellbook].edition << std::endl;
+		out << "# of spells: " << total_spells << 
+		" | Average Success Rate: " << spellbooks[num_spellbook].avg_success_rate  
+		<< std::endl;
+
+		print_spells_info(spellbooks, num_spellbook, status, out);
+}
+
+/*
+ * Function: count_visible_spells
+ * Description: Counts the spells of a spellbook that user is allowed to see.
+ * Parameters:
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
+ * 		num_spellbook (int): Index of the spellbook to count.
+ * 		status (bool): A boolean value indicating whether user is a student or not.
+ * Returns: Number of spells, not counting poison and death spells if user is
+ * 		a student.
+ */
+int count_visible_spells(spellbook* spellbooks, int num_spellbook, bool status) {
+	int total_spells = spellbooks[num_spellbook].num_spells;
+
+	if (status == 1) {
+		for (int j = 0; j < spellbooks[num_spellbook].num_spells; j++) {
+			if (spellbooks[num_spellbook].spells[j].effect == "poison" or 
+			spellbooks[num_spellbook].spells[j].effect == "death") {
+				total_spells += -1;
+			}
+		}
+	}
+
+	return total_spells;
+}
+
+/*
+ * Function: print_spellbooks
+ * Description: Checks if user is a student and prints spellbook info accordingly.
+ * Parameters:
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
+ * 		num_spellbook (int): Index of the spellbook to be printed.
+ * 		status (bool): A boolean value indicating whether user is a student or not.
+ * 		out (std::ostream&): Stream to write to.
+ */
+void print_spellbooks(spellbook* spellbooks, int num_spellbook, bool status, std::ostream& out) {
+	int total_spells = count_visible_spells(spellbooks, num_spellbook, status);
+
+	if (status == 1) {
+		if (total_spells < 1) {
+			//do nothing - do not print spellbook
+		} else {
+			print_spellbook_info(spellbooks, num_spellbook, status, total_spells, out);
+		}
+	} else {
+	print_spellbook_info(spellbooks, num_spellbook, status, total_spells, out);
+	}
+}
+
+/*
+ * Function: is_hidden_book
+ * Description: Checks whether a spellbook is left out of results for user. A
+ * 		student cannot see spellbooks with no spells other than poison and death.
+ * Parameters:
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
+ * 		num_spellbook (int): Index of the spellbook to check.
+ * 		status (bool): A boolean value indicating whether user is a student or not.
+ * Returns: Boolean value 1 if the spellbook is not printed for user, otherwise 0.
+ */
+bool is_hidden_book(spellbook* spellbooks, int num_spellbook, bool status) {
+	return status == 1 and count_visible_spells(spellbooks, num_spellbook, status) < 1;
+}
+
+/*
+ * Function: render_spellbooks
+ * Description: Writes the information of a range of spellbooks to a stream, in
+ * 		order. Used by each display_range worker to fill its own buffer.
+ * Parameters:
+ * 		status (bool): A boolean value indicating whether user is a student or not.
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
+ * 		first (int): Index of the first spellbook to write.
+ * 		last (int): Index one past the last spellbook to write.
+ * 		out (std::ostream*): Stream to write to.
+ */
+void render_spellbooks(bool status, spellbook* spellbooks, int first, int last, std::ostream* out) {
+	for (int i = first; i < last; i++) {
+		print_spellbooks(spellbooks, i, status, *out);
+	}
+}
+
+/*
+ * Function: render_chunks
+ * Description: Worker loop of display_range. Claims chunks in order and
+ * 		formats each into its buffer, waiting while every buffer is still
+ * 		waiting to be printed.
+ * Parameters:
+ * 		queue (render_queue*): A pointer to the shared chunk buffers.
+ */
+void render_chunks(render_queue* queue) {
+	int num_buffers = queue->buffers.size();
+
+	while (true) {
+		std::unique_lock<std::mutex> guard(queue->lock);
+		queue->changed.wait(guard, [queue, num_buffers] {
+			return queue->next_chunk == queue->num_chunks or
+			queue->next_chunk < queue->num_written + num_buffers;
+		});
+		if (queue->next_chunk == queue->num_chunks) {
+			return;
+		}
+		int chunk = queue->next_chunk++;
+		guard.unlock();
+
+		std::ostringstream& buffer = queue->buffers[chunk % num_buffers];
+		int chunk_first = queue->first + chunk * queue->chunk_size;
+		buffer.str("");
+		render_spellbooks(queue->status, queue->spellbooks, chunk_first,
+		std::min(chunk_first + queue->chunk_size, queue->last), &buffer);
+
+		guard.lock();
+		queue->ready[chunk % num_buffers] = 1;
+		queue->changed.notify_all();
+	}
+}
+
+/*
+ * Function: display_range
+ * Description: Displays information of a range of spellbooks, including its spells
+ * 		info. Does not print poison and death spells if user is a student. Large
+ * 		ranges are split into chunks formatted by worker threads a few chunks
+ * 		ahead of the output, which prints them in chunk order, so the output
+ * 		matches printing one spellbook at a time.
+ * Parameters:
+ * 		status (bool): A boolean value indicating whether user is a student or not.
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
+ * 		first (int): Index of the first spellbook to display.
+ * 		last (int): Index one past the last spellbook to display.
+ * Side effects: Prints spellbooks information to terminal.
+ */
+void display_range(bool status, spellbook* spellbooks, int first, int last) {
+	const int chunk_size = 256;
+	int num_chunks = (last - first + chunk_size - 1) / chunk_size;
+	int num_workers = worker_count(num_chunks);
+
+	if (num_workers < 2) {
+		render_spellbooks(status, spellbooks, first, last, &std::cout);
+		return;
+	}
+
+	render_queue queue;
+	queue.status = status;
+	queue.spellbooks = spellbooks;
+	queue.first = first;
+	queue.last = last;
+	queue.chunk_size = chunk_size;
+	queue.num_chunks = num_chunks;
+	queue.buffers.resize(2 * num_workers);
+	queue.ready.assign(2 * num_workers, 0);
+
+	std::vector<std::thread> workers;
+	for (int t = 0; t < num_workers; t++) {
+		workers.emplace_back(render_chunks, &queue);
+	}
+
+	// write buffers out in spellbook order
+	for (int chunk = 0; chunk < num_chunks; chunk++) {
+		int slot = chunk % queue.buffers.size();
+		{
+			std::unique_lock<std::mutex> guard(queue.lock);
+			queue.changed.wait(guard, [&queue, slot] { return queue.ready[slot] != 0; });
+		}
+		std::cout << queue.buffers[slot].str();
+
+		std::lock_guard<std::mutex> guard(queue.lock);
+		queue.ready[slot] = 0;
+		queue.num_written++;
+		queue.changed.notify_all();
+	}
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	std::cout.flush();
+}
+
+/*
+ * Function: print_effects
+ * Description: Prints information of a range of spells with user requested effect
+ * 		to terminal.
+ * Parameters:
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbook structures.
+ * 		refs (const std::vector<spell_ref>&): Spells with the requested effect,
+ * 		from the effect index.
+ * 		first (long): Index in refs of the first spell to print.
+ * 		last (long): Index in refs one past the last spell to print.
+ * Side effects: Prints spells with requested effect to terminal.
+ */
+void print_effects(spellbook* spellbooks, const std::vector<spell_ref>& refs, long first, long last) {
+	for (long i = first; i < last; i++) {
+		const spell& s = spellbooks[refs[i].book].spells[refs[i].spell];
+		std::cout << s.name << " " << s.success_rate << " " << s.effect << std::endl;
+	}
+}
+
+/*
+ * Function: page_end
+ * Description: Finds where the current page of a list of results ends.
+ * Parameters:
+ * 		cursor (const result_cursor&): Cursor at the start of the page.
+ * 		num_results (long): Number of results in the list.
+ * Returns: Index one past the last result on the page.
+ */
+long page_end(const result_cursor& cursor, long num_results) {
+	if (cursor.page_size == 0 or num_results - cursor.position < cursor.page_size) {
+		return num_results;
+	}
+
+	return cursor.position + cursor.page_size;
+}
+
+/*
+ * Function: book_page_end
+ * Description: Finds where the current page of a list of spellbook results
+ * 		ends, counting only spellbooks that user is allowed to see.
+ * Parameters:
+ * 		cursor (const result_cursor&): Cursor at the start of the page.
+ * 		status (bool): A boolean value indicating whether user is a student or not.
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbook structures.
+ * 		books (const int*): Spellbook index of each result, or nullptr if result
+ * 		i is spellbook i.
+ * 		num_results (long): Number of results in the list.
+ * Returns: Index one past the last result on the page.
+ */
+long book_page_end(const result_cursor& cursor, bool status, spellbook* spellbooks, const int* books,
+long num_results) {
+	if (cursor.page_size == 0) {
+		return num_results;
+	}
+
+	long shown = 0;
+	long last = cursor.position;
+	while (last < num_results and shown < cursor.page_size) {
+		if (not is_hidden_book(spellbooks, books ? books[last] : last, status)) {
+			shown++;
 		}
+		last++;
 	}
-return login_success;
+
+	return last;
 }
 
 /*
- * Function: print_wizard
- * Description: Prints the information of the wizard that has logged in.
- * Parameters: 
- * 		login_wizard (wizard*): A pointer to the wizard array containing
- *  	information	from the wizard info text file.		
- * Side effects: Prints logged in wizard's information to terminal.
+ * Function: skip_hidden_books
+ * Description: Skips spellbook results that user cannot see, so an empty page
+ * 		is never offered.
+ * Parameters:
+ * 		position (long): Index of the first result to check.
+ * 		status (bool): A boolean value indicating whether user is a student or not.
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbook structures.
+ * 		books (const int*): Spellbook index of each result, or nullptr if result
+ * 		i is spellbook i.
+ * 		num_results (long): Number of results in the list.
+ * Returns: Index of the next result user can see, or num_results if none.
  */
-void print_wizard(wizard* login_wizard, int which_wiz) {
-	std::cout << "Hello, " << login_wizard[which_wiz].name << "." << std::endl;
-	std::cout << "ID: " << login_wizard[which_wiz].id << std::endl;
-	std::cout << "Status: " << login_wizard[which_wiz].position_title << std::endl;
-	std::cout << "Beard Length: " << login_wizard[which_wiz].beard_length << std::endl;
+long skip_hidden_books(long position, bool status, spellbook* spellbooks, const int* books,
+long num_results) {
+	while (position < num_results and is_hidden_book(spellbooks, books ? books[position] : position, status)) {
+		position++;
+	}
+
+	return position;
 }
 
 /*
- * Function: check_status
- * Description: Checks whether logged in user is a student.
+ * Function: next_page
+ * Description: Prints the page of results a cursor points at and moves the
+ * 		cursor to the following page. Each page costs about its own size, since
+ * 		title and effect results come straight from their indexes. Does not
+ * 		print poison and death spells if user is a student.
  * Parameters:
- * 		wizards (wizard*): A pointer to the wizard structures array.
- * 		wiz_number (int): The index of the logged in wizard in the wizard array.
- * Returns: Boolean value 0, or 1 if user is a student.
+ * 		cursor (result_cursor&): A reference to the cursor to advance.
+ * 		status (bool): A boolean value indicating whether user is a student or not.
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbook structures.
+ * 		num_books (int): Number of spellbooks in dynamic array of spellbook structures.
+ * 		titles (const title_index&): Title index of the spellbooks.
+ * 		effects (const effect_index&): Effect index of the spellbooks.
+ * Returns: Boolean value 0, or 1 if more results follow the printed page.
  */
-bool check_status(wizard* wizards, int wiz_number) {
-	bool status = 0;
+bool next_page(result_cursor& cursor, bool status, spellbook* spellbooks, int num_books,
+const title_index& titles, const effect_index& effects) {
+	// spellbook pages hold page_size spellbooks that user is allowed to see
+	if (cursor.kind == 'd') {
+		long last = book_page_end(cursor, status, spellbooks, nullptr, num_books);
+		if (cursor.position < last) {
+			display_range(status, spellbooks, cursor.position, last);
+		}
+		cursor.position = skip_hidden_books(last, status, spellbooks, nullptr, num_books);
+		return cursor.position < num_books;
+	}
 
-	if (wizards[wiz_number].position_title == "Student") {
-		status = 1;
+	if (cursor.kind == 't') {
+		int id = find_title(titles, spellbooks, cursor.key);
+		if (id == -1) {
+			return 0;
+		}
+		const int* books = titles.books.data() + titles.book_offsets[id];
+		long num_results = titles.book_offsets[id + 1] - titles.book_offsets[id];
+		long last = book_page_end(cursor, status, spellbooks, books, num_results);
+		for (long i = cursor.position; i < last; i++) {
+			print_spellbooks(spellbooks, books[i], status, std::cout);
+		}
+		cursor.position = skip_hidden_books(std::max(cursor.position, last), status, spellbooks, books,
+		num_results);
+		return cursor.position < num_results;
 	}
 
-	return status;
+	if (cursor.kind == 'e') {
+		auto found = effects.spells.find(cursor.key);
+		if (found == effects.spells.end()) {
+			return 0;
+		}
+		const std::vector<spell_ref>& refs = found->second;
+		long last = page_end(cursor, refs.size());
+		print_effects(spellbooks, refs, cursor.position, last);
+		cursor.position = std::max(cursor.position, last);
+		return cursor.position < (long) refs.size();
+	}
+
+	return 0;
 }
 
 /*
- * Function: print_spells_info
- * Description: Prints information of a spell.
+ * Function: cursor_token
+ * Description: Encodes a cursor as an opaque resume token.
  * Parameters:
- * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
- * 		num_spellbook (int): Index of the spellbook to be printed.
- * 		status (bool): A boolean value indicating whether user is a student or not.
- * Side effects: Prints spell information to terminal.
+ * 		cursor (const result_cursor&): Cursor to encode.
+ * Returns: The cursor's kind, page size, position and key, written out in hex.
  */
-void print_spells_info(spellbook* spellbooks, int num_spellbook, bool status) {
-	
-	for (int i = 0; i < spellbooks[num_spellbook].num_spells; i++) {
-		if (status == 1) {
-			if (spellbooks[num_spellbook].spells[i].effect == "poison" or
-			spellbooks[num_spellbook].spells[i].effect == "death") {
-				// do nothing
-			} else {
-			std::cout << spellbooks[num_spellbook].spells[i].name << " " <<
-			spellbooks[num_spellbook].spells[i].success_rate << " " <<
-			spellbooks[num_spellbook].spells[i].effect << std::endl;
-			}
-		} else {
-			std::cout << spellbooks[num_spellbook].spells[i].name << " " <<
-			spellbooks[num_spellbook].spells[i].success_rate << " " <<
-			spellbooks[num_spellbook].spells[i].effect << std::endl;
-		}
+std::string cursor_token(const result_cursor& cursor) {
+	const char digits[] = "0123456789abcdef";
+	std::ostringstream plain;
+	plain << cursor.kind << ' ' << cursor.page_size << ' ' << cursor.position << ' ' << cursor.key;
+
+	std::string token;
+	for (unsigned char c : plain.str()) {
+		token += digits[c >> 4];
+		token += digits[c & 15];
 	}
+
+	return token;
 }
 
 /*
- * Function: print_spellbook_info
- * Description: Prints information of a spellbook, including its spells' info.
+ * Function: parse_cursor_token
+ * Description: Decodes a resume token made by cursor_token.
  * Parameters:
- * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
- * 		num_spellbook (int): Index of the spellbook to be printed.
- * 		status (bool): A boolean value indicating whether user is a student or not.
- * 		total_spells (int): Number of spells available for user to see.
- * Side effects: Prints spellbook information to terminal.
+ * 		token (const std::string&): Resume token input by user.
+ * 		cursor (result_cursor&): A reference to the cursor to decode into.
+ * Returns: Boolean value 0, or 1 if the token is valid.
  */
-void print_spellbook_info(spellbook* spellbooks, int num_spellbook, bool status, int total_spells) {
-		std::cout << "Title: " << spellbooks[num_spellbook].title << " | Author: " 
-		<< spellbooks[num_spellbook].author << std::endl;
-		std::cout << "# of pages: " << spellbooks[num_spellbook].num_pages << 
-		" | Edition: " << spellbooks[num_spellbook].edition << std::endl;
-		std::cout << "# of spells: " << total_spells << 
-		" | Average Success Rate: " << spellbooks[num_spellbook].avg_success_rate  
-		<< std::endl;
+bool parse_cursor_token(const std::string& token, result_cursor& cursor) {
+	if (token.size() % 2 != 0) {
+		return 0;
+	}
+
+	std::string plain;
+	for (size_t i = 0; i < token.size(); i += 2) {
+		std::string byte = token.substr(i, 2);
+		if (not std::isxdigit(static_cast<unsigned char>(byte[0])) or
+		not std::isxdigit(static_cast<unsigned char>(byte[1]))) {
+			return 0;
+		}
+		plain += static_cast<char>(std::stoi(byte, nullptr, 16));
+	}
+
+	std::istringstream fields(plain);
+	if (not (fields >> cursor.kind >> cursor.page_size >> cursor.position) or fields.get() != ' ') {
+		return 0;
+	}
+	std::getline(fields, cursor.key);
 
-		print_spells_info(spellbooks, num_spellbook, status);
+	return (cursor.kind == 'd' or cursor.kind == 't' or cursor.kind == 'e') and
+	cursor.page_size >= 0 and cursor.position >= 0;
 }
 
 /*
- * Function: print_spellbooks
- * Description: Checks if user is a student and prints spellbook info accordingly.
+ * Function: page_results
+ * Description: Prints results a page at a time. After each page that has more
+ * 		results after it, prints a resume token and asks whether to continue.
  * Parameters:
- * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
- * 		num_spellbook (int): Index of the spellbook to be printed.
+ * 		cursor (result_cursor&): A reference to the cursor to start from.
  * 		status (bool): A boolean value indicating whether user is a student or not.
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbook structures.
+ * 		num_books (int): Number of spellbooks in dynamic array of spellbook structures.
+ * 		titles (const title_index&): Title index of the spellbooks.
+ * 		effects (const effect_index&): Effect index of the spellbooks.
  */
-void print_spellbooks(spellbook* spellbooks, int num_spellbook, bool status) {
-	int total_spells = spellbooks[num_spellbook].num_spells;
+void page_results(result_cursor& cursor, bool status, spellbook* spellbooks, int num_books,
+const title_index& titles, const effect_index& effects) {
+	while (next_page(cursor, status, spellbooks, num_books, titles, effects) == 1) {
+		std::string user_input;
 
-	if (status == 1) {
-		for (int j = 0; j < spellbooks[num_spellbook].num_spells; j++) {
-			if (spellbooks[num_spellbook].spells[j].effect == "poison" or 
-			spellbooks[num_spellbook].spells[j].effect == "death") {
-				total_spells += -1;
-			}
+		std::cout << "Resume token: " << cursor_token(cursor) << std::endl;
+		std::cout << "Enter n for the next page or q to return to the menu: ";
+		std::cin >> user_input;
+
+		if (user_input != "n") {
+			return;
 		}
-		if (total_spells < 1) {
-			//do nothing - do not print spellbook
-		} else {
-			print_spellbook_info(spellbooks, num_spellbook, status, total_spells);
-		}		
-	} else {
-	print_spellbook_info(spellbooks, num_spellbook, status, total_spells);
-	} 
+	}
 }
 
 /*
  * Function: display_all
- * Description: Displays information of all spellbooks, including its spells info. 
- * 		Does not print poison and death spells if user is a student.
+ * Description: Displays information of all spellbooks, including its spells info,
+ * 		a page at a time. Does not print poison and death spells if user is a
+ * 		student.
  * Parameters:
  * 		status (bool): A boolean value indicating whether user is a student or not.
  * 		spellbooks (spellbook*): A pointer to dynamic array of spellbooks.
  * 		num_books (int): Number of spellbooks in dynamic array of spellbook structures.
+ * 		page_size (long): Spellbooks per page, or 0 for all spellbooks at once.
  * Side effects: Prints all spellbooks information to terminal.
  */
-void display_all(bool status, spellbook* spellbooks, int num_books) {
-	for (int i = 0; i < num_books; i++) {
-		print_spellbooks(spellbooks, i, status);
-	}
+void display_all(bool status, spellbook* spellbooks, int num_books, long page_size) {
+	result_cursor cursor{'d', "", 0, page_size};
+	title_index no_titles;
+	effect_index no_effects;
+
+	page_results(cursor, status, spellbooks, num_books, no_titles, no_effects);
 }
 
 /*
@@ -569,26 +2315,35 @@ std::string prompt_name() {
 /*
  * Function: search_name
  * Description: Prompts user for a spellbook title  and displays spellbook information
- *		if input is valid. Does not print poison and death spells if user is a student.
-*		Returns to selection options if invalid title.
+ *		a page at a time if input is valid. Does not print poison and death spells if
+ *		user is a student. Suggests the closest titles and returns to selection options
+ *		if invalid title.
  * Parameters:
  * 		status (bool): A boolean value indicating whether user is a student or not.
  * 		spellbooks (spellbook*): A pointer to dynamic array of spellbook structures.
  * 		num_books (int): Number of spellbooks in dynamic array of spellbook structures.
+ * 		titles (const title_index&): Title index of the spellbooks.
+ * 		page_size (long): Spellbooks per page, or 0 for all spellbooks at once.
  */
-void search_name(bool status, spellbook* spellbooks, int num_books) {
+void search_name(bool status, spellbook* spellbooks, int num_books, const title_index& titles,
+long page_size) {
 	std::string title = prompt_name();
-	bool match_found = 0;
 
-	for (int i = 0; i < num_books; i++) {
-		if (title == spellbooks[i].title) {
-			print_spellbooks(spellbooks, i, status);
-			match_found = 1;
-		} 
+	if (find_title(titles, spellbooks, title) != -1) {
+		result_cursor cursor{'t', title, 0, page_size};
+		effect_index no_effects;
+		page_results(cursor, status, spellbooks, num_books, titles, no_effects);
+		return;
 	}
 
-	if (match_found == 0) {
-		std::cout << "No spellbook with that title found." << std::endl;
+	std::cout << "No spellbook with that title found." << std::endl;
+
+	std::vector<int> suggestions = fuzzy_titles(titles, spellbooks, status, title, 5);
+	if (suggestions.size() > 0) {
+		std::cout << "Did you mean:" << std::endl;
+		for (int id : suggestions) {
+			std::cout << "  " << title_text(titles, spellbooks, id) << std::endl;
+		}
 	}
 }
 
@@ -598,21 +2353,20 @@ void search_name(bool status, spellbook* spellbooks, int num_books) {
  * Parameters:
  * 		file_name (std::string): User input for file name.
  * 		spellbooks (spellbook*): A pointer to a dynamic array of spellbook structures.
- * 		num_books (int): Number of spellbooks in dynamic array of spellbook structures.
+ * 		effects (const effect_index&): Effect index of the spellbooks.
  * 		effect (std::string): User requested effect. 
  * Side effects: Creates or appends a file with the requested spell information.
  */
-void append_effects(std::string file_name, spellbook* spellbooks, int num_books, std::string effect) {
+void append_effects(std::string file_name, spellbook* spellbooks, const effect_index& effects,
+std::string effect) {
 	std::ofstream file;
 	file.open(file_name, std::ofstream::app);
 
-	for (int i = 0; i < num_books; i++) {
-		for (int j = 0; j < spellbooks[i].num_spells; j++) {	
-			if (spellbooks[i].spells[j].effect == effect) {
-				file << spellbooks[i].spells[j].name << " " <<
-				spellbooks[i].spells[j].success_rate << " " <<
-				spellbooks[i].spells[j].effect << std::endl;	
-			}
+	auto found = effects.spells.find(effect);
+	if (found != effects.spells.end()) {
+		for (const spell_ref& ref : found->second) {
+			const spell& s = spellbooks[ref.book].spells[ref.spell];
+			file << s.name << " " << s.success_rate << " " << s.effect << std::endl;
 		}
 	}
 	std::cout << "Spells copied to file." << std::endl;
@@ -632,27 +2386,6 @@ std::string file_name() {
 	return user_input;
 }
 
-/*
- * Function: print_effects
- * Description: Prints information of spells with user requested effect to terminal.
- * Parameters:
- * 		spellbooks (spellbook*): A pointer to dynamic array of spellbook structures.
- * 		num_books (int): Number of spellbooks in dynamic array of spellbook structures.
- * 		effect (std::string): User requested effect. 
- * Side effects: Prints spells with requested effect from every spellbook to terminal.
- */
-void print_effects(spellbook* spellbooks, int num_books, std::string effect, bool status) {
-	for (int i = 0; i < num_books; i++) {
-		for (int j = 0; j < spellbooks[i].num_spells; j++) {
-			if (spellbooks[i].spells[j].effect == effect) {
-				std::cout << spellbooks[i].spells[j].name << " " <<
-				spellbooks[i].spells[j].success_rate << " " <<
-				spellbooks[i].spells[j].effect << std::endl;
-			}
-		}
-	}
-}
-
 /*
  * Function: prompt_method
  * Description: Prompts user for preferred method of information display- 1 for
@@ -718,40 +2451,389 @@ std::string prompt_effect(bool status) {
  * 		status (bool): A boolean value indicating whether user is a student or not.
  * 		spellbooks (spellbook*): A pointer to dynamic array of spellbook structures.
  * 		num_books (int): Number of spellbooks in dynamic array of spellbook structures.
+ * 		effects (const effect_index&): Effect index of the spellbooks.
+ * 		page_size (long): Spells per page when printing, or 0 for all spells at once.
  */
-void search_effect(bool status, spellbook* spellbooks, int num_books) {
+void search_effect(bool status, spellbook* spellbooks, int num_books, const effect_index& effects,
+long page_size) {
 	std::string effect = prompt_effect(status);
 
 	int method = prompt_method();
 
 	if (method == 1) {
-		print_effects(spellbooks, num_books, effect, status);
+		result_cursor cursor{'e', effect, 0, page_size};
+		title_index no_titles;
+		page_results(cursor, status, spellbooks, num_books, no_titles, effects);
 	}
 
 	if (method == 2) {
 		std::string file = file_name();
-		append_effects(file, spellbooks, num_books, effect);
+		append_effects(file, spellbooks, effects, effect);
+	}
+}
+
+/*
+ * Function: summarize_values
+ * Description: Computes the count, min, mean, max, median and 90th percentile
+ * 		of a group of values. Percentiles use the nearest rank. Min, max and
+ * 		sum are kept in eight separate lanes with branch-free updates, so the
+ * 		compiler can vectorize the loop without reordering any one lane's sum.
+ * Parameters:
+ * 		values (float*): A pointer to the group's values. They are reordered.
+ * 		count (long): Number of values in the group.
+ * Returns: The summarized statistics of the group.
+ */
+value_stats summarize_values(float* values, long count) {
+	const int num_lanes = 8;
+	value_stats stats;
+	stats.count = count;
+	if (count == 0) {
+		return stats;
+	}
+
+	float lane_min[num_lanes];
+	float lane_max[num_lanes];
+	double lane_sum[num_lanes];
+	for (int l = 0; l < num_lanes; l++) {
+		lane_min[l] = values[0];
+		lane_max[l] = values[0];
+		lane_sum[l] = 0;
+	}
+
+	long i = 0;
+	for (; i + num_lanes <= count; i += num_lanes) {
+		for (int l = 0; l < num_lanes; l++) {
+			float value = values[i + l];
+			lane_min[l] = value < lane_min[l] ? value : lane_min[l];
+			lane_max[l] = value > lane_max[l] ? value : lane_max[l];
+			lane_sum[l] += value;
+		}
+	}
+	for (; i < count; i++) {
+		lane_min[0] = values[i] < lane_min[0] ? values[i] : lane_min[0];
+		lane_max[0] = values[i] > lane_max[0] ? values[i] : lane_max[0];
+		lane_sum[0] += values[i];
+	}
+
+	double sum = 0;
+	stats.min = lane_min[0];
+	stats.max = lane_max[0];
+	for (int l = 0; l < num_lanes; l++) {
+		stats.min = std::min(stats.min, lane_min[l]);
+		stats.max = std::max(stats.max, lane_max[l]);
+		sum += lane_sum[l];
+	}
+	stats.mean = sum / count;
+
+	long median_rank = (count + 1) / 2 - 1;
+	std::nth_element(values, values + median_rank, values + count);
+	stats.median = values[median_rank];
+
+	long p90_rank = (count * 9 + 9) / 10 - 1;
+	std::nth_element(values, values + p90_rank, values + count);
+	stats.p90 = values[p90_rank];
+
+	return stats;
+}
+
+/*
+ * Function: summarize_groups
+ * Description: Summarizes every group of a flat array of values, several
+ * 		groups at once.
+ * Parameters:
+ * 		values (std::vector<float>&): A reference to the values of all groups,
+ * 		grouped by group id. They are reordered.
+ * 		offsets (const std::vector<long>&): Start of each group in values, plus
+ * 		the end of the last group.
+ * Returns: The summarized statistics of each group, by group id.
+ */
+std::vector<value_stats> summarize_groups(std::vector<float>& values, const std::vector<long>& offsets) {
+	const int min_chunk_size = 64;
+	int num_groups = offsets.size() - 1;
+	int num_workers = worker_count((num_groups + min_chunk_size - 1) / min_chunk_size);
+
+	std::vector<value_stats> stats(num_groups);
+	run_in_chunks(num_groups, num_workers, [&](int, int first, int last) {
+		for (int g = first; g < last; g++) {
+			stats[g] = summarize_values(values.data() + offsets[g], offsets[g + 1] - offsets[g]);
+		}
+	});
+
+	return stats;
+}
+
+/*
+ * Function: is_hidden_effect
+ * Description: Checks whether spells of an effect are hidden from students.
+ * Parameters:
+ * 		effect (const std::string&): Spell effect.
+ * Returns: Boolean value 1 for poison and death, or 0 otherwise.
+ */
+bool is_hidden_effect(const std::string& effect) {
+	return effect == "poison" or effect == "death";
+}
+
+/*
+ * Function: compute_stats
+ * Description: Computes per-effect and per-author success rate statistics and
+ * 		per-edition page count statistics. Effects, authors and editions are
+ * 		each numbered once, effects from the effect index and authors and
+ * 		editions once per spellbook rather than once per spell. Then one pass
+ * 		over all spells, split into chunks of spellbooks across worker
+ * 		threads, copies each success rate straight to its place in a flat
+ * 		per-effect and a flat per-author array, ordered by group number, and
+ * 		each group is summarized from its slice of the array.
+ * Parameters:
+ * 		status (bool): A boolean value indicating whether user is a student or not.
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbook structures.
+ * 		num_books (int): Number of spellbooks in dynamic array of spellbook structures.
+ * 		effects (const effect_index&): Effect index of the spellbooks.
+ * Returns: The summarized catalog statistics.
+ */
+catalog_stats compute_stats(bool status, spellbook* spellbooks, int num_books, const effect_index& effects) {
+	const int min_chunk_size = 1024;
+	int num_workers = worker_count((num_books + min_chunk_size - 1) / min_chunk_size);
+	catalog_stats stats;
+
+	// number effects, leaving hidden ones out, and count the visible spells of each spellbook
+	std::vector<const std::string*> effect_names;
+	std::vector<const std::vector<spell_ref>*> effect_refs;
+	std::vector<int> num_visible(num_books);
+	for (int i = 0; i < num_books; i++) {
+		num_visible[i] = spellbooks[i].spells.size();
+	}
+	for (const auto& effect : effects.spells) {
+		if (status == 1 and is_hidden_effect(effect.first)) {
+			for (const spell_ref& ref : effect.second) {
+				num_visible[ref.book]--;
+			}
+			continue;
+		}
+		effect_names.push_back(&effect.first);
+		effect_refs.push_back(&effect.second);
+	}
+	std::vector<long> effect_offsets(effect_refs.size() + 1, 0);
+	for (size_t e = 0; e < effect_refs.size(); e++) {
+		effect_offsets[e + 1] = effect_offsets[e] + effect_refs[e]->size();
+	}
+
+	// number authors and editions once per spellbook
+	std::unordered_map<std::string, int> author_ids;
+	std::vector<const std::string*> author_names;
+	std::map<int, int> edition_ids;
+	std::vector<int> book_authors(num_books);
+	std::vector<int> book_editions(num_books);
+	for (int i = 0; i < num_books; i++) {
+		auto author = author_ids.find(spellbooks[i].author);
+		if (author == author_ids.end()) {
+			author = author_ids.emplace(spellbooks[i].author, author_names.size()).first;
+			author_names.push_back(&spellbooks[i].author);
+		}
+		book_authors[i] = author->second;
+		book_editions[i] = edition_ids.emplace(spellbooks[i].edition, edition_ids.size()).first->second;
+	}
+	author_ids = std::unordered_map<std::string, int>();
+
+	// place each spellbook's values in its author's and edition's slice, leaving out
+	// spellbooks a student cannot see
+	std::vector<long> author_offsets(author_names.size() + 1, 0);
+	std::vector<long> edition_offsets(edition_ids.size() + 1, 0);
+	for (int i = 0; i < num_books; i++) {
+		author_offsets[book_authors[i] + 1] += num_visible[i];
+		edition_offsets[book_editions[i] + 1] += status == 0 or num_visible[i] > 0;
+	}
+	for (size_t a = 0; a + 1 < author_offsets.size(); a++) {
+		author_offsets[a + 1] += author_offsets[a];
+	}
+	for (size_t e = 0; e + 1 < edition_offsets.size(); e++) {
+		edition_offsets[e + 1] += edition_offsets[e];
+	}
+	std::vector<long> author_next(author_offsets.begin(), author_offsets.end() - 1);
+	std::vector<long> edition_next(edition_offsets.begin(), edition_offsets.end() - 1);
+	std::vector<long> author_starts(num_books);
+	std::vector<long> edition_starts(num_books, -1);
+	for (int i = 0; i < num_books; i++) {
+		author_starts[i] = author_next[book_authors[i]];
+		author_next[book_authors[i]] += num_visible[i];
+		if (status == 0 or num_visible[i] > 0) {
+			edition_starts[i] = edition_next[book_editions[i]]++;
+		}
+	}
+
+	// one pass over the visible spells: each worker takes a chunk of spellbooks and
+	// walks that chunk's part of every effect's spells, which are in catalog order
+	std::vector<float> effect_values(effect_offsets.back());
+	std::vector<float> author_values(author_offsets.back());
+	std::vector<float> edition_values(edition_offsets.back());
+	run_in_chunks(num_books, num_workers, [&](int, int first, int last) {
+		auto before = [](const spell_ref& ref, int book) { return ref.book < book; };
+		for (size_t e = 0; e < effect_refs.size(); e++) {
+			const std::vector<spell_ref>& refs = *effect_refs[e];
+			long k = std::lower_bound(refs.begin(), refs.end(), first, before) - refs.begin();
+			long end = std::lower_bound(refs.begin() + k, refs.end(), last, before) - refs.begin();
+			for (; k < end; k++) {
+				float rate = spellbooks[refs[k].book].spells[refs[k].spell].success_rate;
+				effect_values[effect_offsets[e] + k] = rate;
+				author_values[author_starts[refs[k].book]++] = rate;
+			}
+		}
+		for (int i = first; i < last; i++) {
+			if (edition_starts[i] != -1) {
+				edition_values[edition_starts[i]] = spellbooks[i].num_pages;
+			}
+		}
+	});
+
+	std::vector<value_stats> effect_stats = summarize_groups(effect_values, effect_offsets);
+	for (size_t e = 0; e < effect_names.size(); e++) {
+		stats.effects[*effect_names[e]] = effect_stats[e];
+	}
+	std::vector<value_stats> author_stats = summarize_groups(author_values, author_offsets);
+	for (size_t a = 0; a < author_names.size(); a++) {
+		stats.authors[*author_names[a]] = author_stats[a];
+	}
+	std::vector<value_stats> edition_stats = summarize_groups(edition_values, edition_offsets);
+	for (const auto& edition : edition_ids) {
+		if (edition_stats[edition.second].count > 0) {
+			stats.editions[edition.first] = edition_stats[edition.second];
+		}
+	}
+
+	return stats;
+}
+
+/*
+ * Function: write_value_stats
+ * Description: Writes one line of statistics for a group.
+ * Parameters:
+ * 		out (std::ostream&): Stream to write to.
+ * 		stats (const value_stats&): Summarized statistics of the group.
+ * 		unit (std::string): What the group counts, such as "spells".
+ */
+void write_value_stats(std::ostream& out, const value_stats& stats, std::string unit) {
+	out << stats.count << " " << unit << " | Min: " << stats.min << " | Mean: " << stats.mean
+	<< " | Max: " << stats.max << " | Median: " << stats.median << " | 90th percentile: "
+	<< stats.p90 << std::endl;
+}
+
+/*
+ * Function: write_stats
+ * Description: Writes catalog statistics, grouped by effect, author and edition.
+ * Parameters:
+ * 		out (std::ostream&): Stream to write to.
+ * 		stats (const catalog_stats&): Summarized catalog statistics.
+ */
+void write_stats(std::ostream& out, const catalog_stats& stats) {
+	out << "Success rate by spell effect:" << std::endl;
+	for (const auto& group : stats.effects) {
+		out << group.first << ": ";
+		write_value_stats(out, group.second, "spells");
+	}
+
+	out << "Success rate by author:" << std::endl;
+	for (const auto& group : stats.authors) {
+		if (group.second.count > 0) {
+			out << group.first << ": ";
+			write_value_stats(out, group.second, "spells");
+		}
+	}
+
+	out << "Number of pages by edition:" << std::endl;
+	for (const auto& group : stats.editions) {
+		out << "Edition " << group.first << ": ";
+		write_value_stats(out, group.second, "spellbooks");
+	}
+}
+
+/*
+ * Function: catalog_statistics
+ * Description: Computes statistics over the whole catalog. Asks whether user
+ * 		would like to print to screen or write to file and does so accordingly.
+ * 		Does not count poison and death spells if user is a student.
+ * Parameters:
+ * 		status (bool): A boolean value indicating whether user is a student or not.
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbook structures.
+ * 		num_books (int): Number of spellbooks in dynamic array of spellbook structures.
+ * 		effects (const effect_index&): Effect index of the spellbooks.
+ */
+void catalog_statistics(bool status, spellbook* spellbooks, int num_books, const effect_index& effects) {
+	int method = prompt_method();
+	catalog_stats stats = compute_stats(status, spellbooks, num_books, effects);
+
+	if (method == 1) {
+		write_stats(std::cout, stats);
+	}
+
+	if (method == 2) {
+		std::ofstream file;
+		file.open(file_name(), std::ofstream::app);
+		write_stats(file, stats);
+		std::cout << "Statistics copied to file." << std::endl;
+	}
+}
+
+/*
+ * Function: prompt_page_size
+ * Description: Prompts user for how many results to show per page until valid.
+ * Returns: Number of results per page, or 0 for all results at once.
+ */
+long prompt_page_size() {
+	long user_input;
+
+	do {
+		std::cout << "How many results per page? (0 for all): ";
+		std::cin >> user_input;
+
+		if (user_input < 0) {
+			std::cout << "That is not a valid input. Try again." << std::endl;
+		}
+	} while (user_input < 0);
+
+	return user_input;
+}
+
+/*
+ * Function: resume_results
+ * Description: Prompts user for a resume token and continues the results it
+ * 		points at, a page at a time. Tokens for poison and death spells are
+ * 		refused if user is a student.
+ * Parameters:
+ * 		status (bool): A boolean value indicating whether user is a student or not.
+ * 		spellbooks (spellbook*): A pointer to dynamic array of spellbook structures.
+ * 		num_books (int): Number of spellbooks in dynamic array of spellbook structures.
+ * 		titles (const title_index&): Title index of the spellbooks.
+ * 		effects (const effect_index&): Effect index of the spellbooks.
+ */
+void resume_results(bool status, spellbook* spellbooks, int num_books, const title_index& titles,
+const effect_index& effects) {
+	std::string token;
+	result_cursor cursor;
+
+	std::cout << "Enter a resume token: ";
+	std::cin >> token;
+
+	if (parse_cursor_token(token, cursor) == 0 or (status == 1 and cursor.kind == 'e' and
+	(cursor.key == "poison" or cursor.key == "death"))) {
+		std::cout << "Invalid resume token." << std::endl;
+		return;
 	}
+
+	page_results(cursor, status, spellbooks, num_books, titles, effects);
 }
 
 /*
  * Function: quit_program
  * Description: Terminates program. Deletes pointers and dynamic arrays to 
- * 		avoid memory leaks.
+ * 		avoid memory leaks. Spellbooks free themselves once their load goes
+ * 		out of scope.
  * Parameters: 
  * 		exit (bool&): A reference to a bool used to quit the program.
  * 		wizards (wizard*&): A reference of the pointer to a dynamic array of wizard structures.
- * 		spellbooks (spellbook*&): A reference of the pointer to a dynamic array of spellbook structures.
- * 		num_books (int): Number of spellbooks in dynamic array of spellbook structures.
- * 		num_wiz (int): Number of wizards in dynamic array of wizard structures.
  * Returns: Modified bool variable.
  * Side effects: Modifies bool exit.
  */
-bool quit_program(bool& exit, wizard*& wizards, spellbook*& spellbooks, int num_books) {
+bool quit_program(bool& exit, wizard*& wizards) {
 	std::cout << "Quitting program." << std::endl;
-	
-	// free spellbooks and spells dynamic arrays
-	delete_spellbooks(spellbooks, num_books);
 
 	// free wizards dynamic array
 	delete_wizards(wizards);
@@ -763,17 +2845,22 @@ bool quit_program(bool& exit, wizard*& wizards, spellbook*& spellbooks, int num_
 
 /*
  * Function: select_option
- * Description: Prompts user to select an option by enternig an integer between 1-4.
+ * Description: Prompts user to select an option by enternig an integer between 1-7.
+ * 		Results are shown all at once until user sets a page size.
  * Parameters:
  * 		status (bool): A boolean value indicating whether user is a student or not.
  * 		spellbooks (spellbook*): A pointer to a dynamic array of spellbook structures.
  * 		num_spellbooks (int): Number of spellbooks in dynamic array of spellbook structures.
  * 		wizards (wizard*): A pointer to the wizard structures array.
+ * 		titles (const title_index&): Title index of the spellbooks.
+ * 		effects (const effect_index&): Effect index of the spellbooks.
  */
-void select_option(bool status, spellbook*& spellbooks, int num_spellbooks, wizard*& wizards) {
+void select_option(bool status, spellbook* spellbooks, int num_spellbooks, wizard*& wizards,
+const title_index& titles, const effect_index& effects) {
 
 	int user_input; 
 	bool exit = 0;
+	long page_size = 0;
 
 	do {
 		do {
@@ -782,61 +2869,95 @@ void select_option(bool status, spellbook*& spellbooks, int num_spellbooks, wiza
 			std::cout << "2 - Search by spellbook name" << std::endl;
 			std::cout << "3 - Search by spell effect" << std::endl;
 			std::cout << "4 - Quit program" << std::endl;		
+			std::cout << "5 - Catalog statistics" << std::endl;
+			std::cout << "6 - Resume results from a token" << std::endl;
+			std::cout << "7 - Set results per page" << std::endl;
 			std::cout << "Your choice: ";
 			std::cin >> user_input;
 
-			if (user_input > 4 or user_input < 1) {
+			if (user_input > 7 or user_input < 1) {
 			std::cout << "That is not a valid input. Try again." << std::endl;
 			}
-		} while (user_input > 4 and user_input < 1);
+		} while (user_input > 7 and user_input < 1);
 		
 		// display all
 		if (user_input == 1) {
-			display_all(status, spellbooks, num_spellbooks);
+			display_all(status, spellbooks, num_spellbooks, page_size);
 		}
 
 		// search book by name
 		if (user_input == 2) {
-			search_name(status, spellbooks, num_spellbooks);
+			search_name(status, spellbooks, num_spellbooks, titles, page_size);
 		}
 
 		// search spells by effect
 		if (user_input == 3) {
-			search_effect(status, spellbooks, num_spellbooks);
+			search_effect(status, spellbooks, num_spellbooks, effects, page_size);
 		}
 
 		// quit do while loop
 		if (user_input == 4) {
-			quit_program(exit, wizards, spellbooks, num_spellbooks);
+			quit_program(exit, wizards);
+		}
+
+		// statistics by effect, author and edition
+		if (user_input == 5) {
+			catalog_statistics(status, spellbooks, num_spellbooks, effects);
+		}
+
+		// continue paged results
+		if (user_input == 6) {
+			resume_results(status, spellbooks, num_spellbooks, titles, effects);
+		}
+
+		// change results per page
+		if (user_input == 7) {
+			page_size = prompt_page_size();
 		}
 	} while (exit == 0);
 }
 
 int main () {
-	// initialize ifstreams
-	std::ifstream wizard_info; 
-	std::ifstream spellbook_info;
+	// initialize input files
+	input_file wizard_info; 
+	std::vector<std::string> spellbook_names;
 
 	// prompt for file names, open files if valid names
-	if (file_prompt(wizard_info, spellbook_info) == 1) {
+	if (file_prompt(wizard_info, spellbook_names) == 1) {
+		// start storing spellbook info in memory while the user logs in
+		spellbook_load load;
+		start_spellbook_load(load, spellbook_names);
+
 		// store wizard info in memory
 		int num_wizards = size_wizards(wizard_info);
-		wizard* wizards = populate_wizards(wizard_info, num_wizards);		
-
-		// prompt for wizard login - 3 times max
-		if (log_in(wizards, num_wizards) == 1) {
+		wizard* wizards = populate_wizards(wizard_info, wizard_info.bad() ? 0 : num_wizards);		
+
+		// prompt for wizard login - 3 times max, unless the wizard file failed to decompress
+		if (wizard_info.bad()) {
+			std::cout << "Error: cannot read wizard file: " << wizard_info.error() << std::endl;
+			delete_wizards(wizards);
+			cancel_spellbook_load(load);
+		} else if (log_in(wizards, num_wizards) == 1) {
 			// display wizard information upon successful login
 			print_wizard(wizards, num_wizards);
 
-			// store spellbook info in memory
-			int num_spellbooks = size_spellbooks(spellbook_info);
-			spellbook* spellbooks = populate_spellbooks(spellbook_info, num_spellbooks);
+			// wait for spellbook info if it is still loading
+			finish_spellbook_load(load);
+			print_load_errors(load);
+			if (print_load_allocations(load) == 0) {
+				delete_wizards(wizards);
+				std::exit(1);
+			}
 
 			// check if user is a student
 			bool status = check_status(wizards, num_wizards);
 
 			// present search options until prompted to quit
-			select_option(status, spellbooks, num_spellbooks, wizards);
+			select_option(status, load.spellbooks.data(), load.spellbooks.size(), wizards, load.titles,
+			load.effects);
+		} else {
+			// stop loading and free spellbook info
+			cancel_spellbook_load(load);
 		}
 	}
 }